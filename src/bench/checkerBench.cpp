@@ -0,0 +1,203 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements DFcheckerBench, which runs the checker end to end on
+// a Tracelog, HBlog and IRlog (e.g. made by DFtracegen) a number
+// of times and prints the time and the throughput of each run. It
+// takes the options of DFchecker, --profile writes the profile of
+// the last run. --verify-exact checks that --exact finds a race on
+// every address on which the history depth given finds one.
+
+#include "checker.hpp"
+#include "validator.hpp"
+#include "binaryTrace.hpp"
+#include "textTrace.hpp"
+#include "shardedTrace.hpp"
+#include "options.hpp"
+#include "profiler.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+// the result of a run
+typedef struct BenchRun {
+  uint64_t  events;
+  double    seconds;   // of the whole run
+  double    traceSeconds; // reading and checking the trace
+} BenchRun;
+
+// reads the logs with "reader" and checks them like DFchecker
+template<typename Reader>
+static BOOL runChecker(const CheckerOptions &options, Profiler &profiler,
+                       BenchRun &run) {
+  NameInterner names;
+  Checker checker(options, names);
+  Reader reader;
+
+  profiler.beginPhase("hb_load");
+  if ( !reader.readHBlog(options.HBlog, checker) ) return false;
+  uint64_t hbEvents = checker.eventCount();
+  profiler.endPhase(hbEvents);
+
+  auto begin = std::chrono::steady_clock::now();
+  profiler.beginPhase("trace");
+  if ( !reader.readTrace(options.traceLog, checker) ) return false;
+  profiler.endPhase(checker.eventCount() - hbEvents);
+
+  double readChecks = checker.checkSeconds();
+  profiler.beginPhase("detection");
+  checker.finishChecking();
+  profiler.endPhase();
+  profiler.moveSeconds("trace", "detection", readChecks);
+  run.traceSeconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin ).count();
+
+  BugValidator validator(names);
+  profiler.beginPhase("ir_index");
+  validator.indexTasksIR(options.IRlog);
+  profiler.endPhase();
+
+  profiler.beginPhase("validation");
+  checker.checkCommutativeOperations(validator);
+  profiler.endPhase();
+
+  checker.addCounters(profiler);
+  validator.addCounters(profiler);
+  run.events = checker.eventCount();
+  return true;
+}
+
+// reads the logs with "reader" into "checker", up to the detection
+template<typename Reader>
+static BOOL checkTrace(const CheckerOptions &options, Checker &checker) {
+  Reader reader;
+  if (!reader.readHBlog(options.HBlog, checker) ||
+      !reader.readTrace(options.traceLog, checker)) {
+    return false;
+  }
+  checker.finishChecking();
+  return true;
+}
+
+// true if --exact finds the racy addresses found with the history depth
+template<typename Reader>
+static BOOL verifyExact(const CheckerOptions &options) {
+  CheckerOptions exactOptions = options;
+  exactOptions.exact = true;
+
+  NameInterner names, exactNames;
+  Checker checker(options, names);
+  Checker exact(exactOptions, exactNames);
+
+  std::ostringstream quiet;
+  std::streambuf *output = std::cout.rdbuf(quiet.rdbuf());
+  BOOL read = checkTrace<Reader>(options, checker) &&
+              checkTrace<Reader>(exactOptions, exact);
+  std::cout.rdbuf(output);
+
+  return read && exact.coversRacyAddresses(checker);
+}
+
+static VOID printUsage() {
+  std::cout << "Usage: ./DFcheckerBench [--repeat N] [--verify-exact] "
+            << "[options] TraceLog.txt HBlog.txt IRlog.txt" << std::endl;
+  std::cout << "  --repeat N   runs of the checker (default 5)"
+            << std::endl;
+  std::cout << "  --verify-exact  checks that --exact finds the "
+            << "racy addresses of the runs" << std::endl;
+  std::cout << "The other options are those of DFchecker:" << std::endl;
+  CheckerOptions::printUsage();
+}
+
+int main(int argc, char *argv[]) {
+  // takes --repeat out, the rest are options of the checker
+  unsigned repeat = 5;
+  BOOL verify = false;
+  std::vector<char *> checkerArgs;
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--verify-exact") == 0) {
+      verify = true;
+    } else {
+      checkerArgs.push_back(argv[i]);
+    }
+  }
+
+  CheckerOptions options;
+  if (repeat == 0 ||
+      !options.parse(checkerArgs.size(), checkerArgs.data()) ||
+      options.stream) {
+    printUsage();
+    exit(-1);
+  }
+  BOOL sharded = ShardedTraceReader::isManifest(options.HBlog);
+  BOOL binary  = BinaryTraceReader::isBinaryLog(options.HBlog);
+
+  std::vector<BenchRun> runs;
+  for (unsigned i = 0; i < repeat; i++) {
+    Profiler profiler;
+    BenchRun run;
+
+    // the checker reports on the standard output, keep it quiet
+    std::ostringstream quiet;
+    std::streambuf *output = std::cout.rdbuf(quiet.rdbuf());
+    auto begin = std::chrono::steady_clock::now();
+    BOOL done = sharded ?
+        runChecker<ShardedTraceReader>(options, profiler, run) : binary ?
+        runChecker<BinaryTraceReader>(options, profiler, run) :
+        runChecker<TextTraceReader>(options, profiler, run);
+    run.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin ).count();
+    std::cout.rdbuf(output);
+
+    if ( !done ) {
+      std::cout << "ERROR! Logs: " << options.traceLog << ", "
+                << options.HBlog << " could not be read." << std::endl;
+      exit(-1);
+    }
+
+    std::cout << "run " << i + 1 << ": " << run.events << " events in "
+              << run.seconds << " s, "
+              << run.events / run.traceSeconds << " events/s checked, "
+              << Profiler::peakMemory() / (1024 * 1024) << " MB peak"
+              << std::endl;
+    runs.push_back(run);
+
+    if (options.profile && i + 1 == repeat &&
+        !profiler.write(options.profile)) {
+      std::cout << "ERROR! Profile: " << options.profile
+                << " could not be written." << std::endl;
+    }
+  }
+
+  if ( verify ) {
+    BOOL covered = sharded ? verifyExact<ShardedTraceReader>(options) :
+                   binary  ? verifyExact<BinaryTraceReader>(options) :
+                             verifyExact<TextTraceReader>(options);
+    std::cout << "exact: " << (covered ? "finds" : "MISSES")
+              << " the racy addresses of depth " << options.historyDepth
+              << std::endl;
+    if ( !covered ) exit(-1);
+  }
+
+  // the median run, less sensitive to the page cache than the first
+  std::sort(runs.begin(), runs.end(),
+            [](const BenchRun &a, const BenchRun &b) {
+              return a.seconds < b.seconds;
+            });
+  const BenchRun &median = runs[runs.size() / 2];
+  std::cout << "median: " << median.seconds << " s, "
+            << median.events / median.traceSeconds << " events/s checked"
+            << ", best: " << runs.front().seconds << " s" << std::endl;
+  return 0;
+}
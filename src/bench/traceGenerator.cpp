@@ -0,0 +1,397 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements DFtracegen, which writes a synthetic Tracelog, HBlog
+// and IRlog for benchmarking the checker without running a dwarf.
+//
+// The tasks run one after the other in a topological order of the
+// task graph. Each task is an instance of one of a few task bodies
+// whose IR lines either update a location commutatively (load, add,
+// store) or store the result of a call. The accesses of a task go
+// to a small set of hot addresses shared by all tasks, which makes
+// the conflicts, or walk the working set from where the previous
+// task stopped.
+
+#include "defs.hpp"
+#include "traceFormat.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// the addresses of the working set, then the hot ones
+#define TRACEGEN_BASE_ADDRESS 0x10000000UL
+#define TRACEGEN_HOT_ADDRESS  0x80000000UL
+
+typedef struct GeneratorOptions {
+  unsigned     tasks     = 1000;   // --tasks N
+  std::string  shape     = "forkjoin"; // --shape=chain|forkjoin|...
+  unsigned     width     = 8;      // --width N: concurrent tasks
+  unsigned     accesses  = 100;    // --accesses N: per task
+  unsigned     addresses = 65536;  // --addresses N: working set
+  unsigned     hot       = 64;     // --hot N: shared addresses
+  double       conflicts = 0.05;   // --conflicts P: to hot addresses
+  double       writes    = 0.5;    // --writes P: writes among them
+  double       commute   = 0.5;    // --commute P: commuting lines
+  unsigned     bodies    = 4;      // --bodies N: task bodies
+  unsigned     lines     = 32;     // --lines N: per task body
+  unsigned     seed      = 1;      // --seed N
+  BOOL         binary    = false;  // --binary: binary Trace/HBlog
+  const char  *prefix    = NULL;
+} GeneratorOptions;
+
+static VOID printUsage() {
+  std::cout << "Usage: ./DFtracegen [options] PREFIX" << std::endl;
+  std::cout << "Writes PREFIXTracelog.txt, PREFIXHBlog.txt and "
+            << "PREFIXIRlog.txt" << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --tasks N        tasks (default 1000)" << std::endl;
+  std::cout << "  --shape=KIND     task graph: chain, forkjoin (default),"
+            << " pipeline or random" << std::endl;
+  std::cout << "  --width N        workers of a fork, pipeline stages or"
+            << " most parents (default 8)" << std::endl;
+  std::cout << "  --accesses N     accesses per task (default 100)"
+            << std::endl;
+  std::cout << "  --addresses N    addresses of the working set "
+            << "(default 65536)" << std::endl;
+  std::cout << "  --hot N          addresses shared by all tasks "
+            << "(default 64)" << std::endl;
+  std::cout << "  --conflicts P    share of the accesses to the hot "
+            << "addresses (default 0.05)" << std::endl;
+  std::cout << "  --writes P       share of writes (default 0.5)"
+            << std::endl;
+  std::cout << "  --commute P      share of IR lines which update "
+            << "commutatively (default 0.5)" << std::endl;
+  std::cout << "  --bodies N       task bodies (default 4)" << std::endl;
+  std::cout << "  --lines N        IR lines per task body (default 32)"
+            << std::endl;
+  std::cout << "  --seed N         random seed (default 1)" << std::endl;
+  std::cout << "  --binary         write the binary Tracelog and HBlog"
+            << std::endl;
+}
+
+// parses "--name N", "--name=N" or "--name P" at argv[i]
+static BOOL optionValue(int argc, char *argv[], int &i,
+                        const char *name, const char *&value) {
+  size_t length = strlen(name);
+  if (strncmp(argv[i], name, length) != 0) return false;
+  if (argv[i][length] == '=') {
+    value = argv[i] + length + 1;
+    return true;
+  }
+  if (argv[i][length] != '\0') return false;
+  value = (i + 1 < argc) ? argv[++i] : "";
+  return true;
+}
+
+static BOOL parseCount(const char *text, unsigned &count) {
+  char *end;
+  unsigned long value = strtoul(text, &end, 10);
+  if (*text == '\0' || *end != '\0' || value == 0) return false;
+  count = static_cast<unsigned>(value);
+  return true;
+}
+
+static BOOL parseShare(const char *text, double &share) {
+  char *end;
+  share = strtod(text, &end);
+  return *text != '\0' && *end == '\0' && share >= 0 && share <= 1;
+}
+
+static BOOL parseOptions(int argc, char *argv[],
+                         GeneratorOptions &options) {
+  for (int i = 1; i < argc; i++) {
+    const char *value = NULL;
+    BOOL valid = true;
+
+    if (optionValue(argc, argv, i, "--tasks", value)) {
+      valid = parseCount(value, options.tasks);
+    } else if (optionValue(argc, argv, i, "--shape", value)) {
+      options.shape = value;
+      valid = options.shape == "chain" || options.shape == "forkjoin" ||
+              options.shape == "pipeline" || options.shape == "random";
+    } else if (optionValue(argc, argv, i, "--width", value)) {
+      valid = parseCount(value, options.width);
+    } else if (optionValue(argc, argv, i, "--accesses", value)) {
+      valid = parseCount(value, options.accesses);
+    } else if (optionValue(argc, argv, i, "--addresses", value)) {
+      valid = parseCount(value, options.addresses);
+    } else if (optionValue(argc, argv, i, "--hot", value)) {
+      valid = parseCount(value, options.hot);
+    } else if (optionValue(argc, argv, i, "--conflicts", value)) {
+      valid = parseShare(value, options.conflicts);
+    } else if (optionValue(argc, argv, i, "--writes", value)) {
+      valid = parseShare(value, options.writes);
+    } else if (optionValue(argc, argv, i, "--commute", value)) {
+      valid = parseShare(value, options.commute);
+    } else if (optionValue(argc, argv, i, "--bodies", value)) {
+      valid = parseCount(value, options.bodies);
+    } else if (optionValue(argc, argv, i, "--lines", value)) {
+      valid = parseCount(value, options.lines);
+    } else if (optionValue(argc, argv, i, "--seed", value)) {
+      valid = parseCount(value, options.seed);
+    } else if (strcmp(argv[i], "--binary") == 0) {
+      options.binary = true;
+    } else if (argv[i][0] == '-' || options.prefix) {
+      valid = false;
+    } else {
+      options.prefix = argv[i];
+    }
+
+    if ( !valid ) {
+      std::cout << "Invalid option: " << argv[i] << std::endl;
+      return false;
+    }
+  }
+  return options.prefix != NULL;
+}
+
+// The parents of each task in the shape of the task graph. Task 0
+// is the root, the parents of a task come before it.
+static VOID makeTaskGraph(const GeneratorOptions &options,
+                          std::mt19937_64 &random,
+                          std::vector<INTVECTOR> &parents) {
+  INTEGER tasks = options.tasks;
+  INTEGER width = options.width;
+  parents.assign(tasks, INTVECTOR());
+
+  for (INTEGER task = 1; task < tasks; task++) {
+    INTVECTOR &taskParents = parents[task];
+
+    if (options.shape == "chain") {
+      taskParents.push_back(task - 1);
+    } else if (options.shape == "forkjoin") {
+      // rounds of a fork task, "width" workers and a join task
+      INTEGER round = (task - 1) / (width + 1);
+      INTEGER index = (task - 1) % (width + 1);
+      INTEGER fork  = round * (width + 1);
+      if (index < width) {
+        taskParents.push_back(fork);
+      } else {
+        for (INTEGER worker = fork + 1; worker < task; worker++) {
+          taskParents.push_back(worker);
+        }
+      }
+    } else if (options.shape == "pipeline") {
+      // items flow through "width" stages, task 0 feeds the first
+      INTEGER item  = (task - 1) / width;
+      INTEGER stage = (task - 1) % width;
+      if (stage > 0) taskParents.push_back(task - 1);
+      if (item > 0)  taskParents.push_back(task - width);
+      if (taskParents.empty()) taskParents.push_back(0);
+    } else { // random DAG over a window of the last tasks
+      INTEGER window = std::min(task, 4 * width);
+      INTEGER count  = 1 + random() % std::min(window, width);
+      for (INTEGER i = 0; i < count; i++) {
+        taskParents.push_back(task - 1 - random() % window);
+      }
+      std::sort(taskParents.begin(), taskParents.end());
+      taskParents.erase(std::unique(taskParents.begin(),
+                                    taskParents.end()),
+                        taskParents.end());
+    }
+  }
+}
+
+// Writes the events in the text or the binary format
+class TraceWriter {
+  public:
+    TraceWriter(FILE *trace_, FILE *hbLog_, BOOL binary_)
+        : trace(trace_), hbLog(hbLog_), binary(binary_) {
+      if ( binary ) {
+        FileWriter traceOut(trace), hbOut(hbLog);
+        TraceFormat::writeHeader(traceOut);
+        TraceFormat::writeHeader(hbOut);
+      }
+    }
+
+    VOID edge(INTEGER task, INTEGER parent) {
+      if ( binary ) {
+        FileWriter out(hbLog);
+        TraceFormat::writeRecord(out, TraceFormat::HB_EDGE, task, 0, parent);
+      } else {
+        fprintf(hbLog, "%ld %ld\n", task, parent);
+      }
+    }
+
+    VOID function(INTEGER funcId, const std::string &name) {
+      if ( binary ) {
+        FileWriter out(trace);
+        TraceFormat::writeRecord(out, TraceFormat::FUNCTION, 0, 0, 0, 0,
+                                 funcId, name.c_str(), name.size());
+      } else {
+        fprintf(trace, "%ld F %s\n", funcId, name.c_str());
+      }
+    }
+
+    VOID begin(INTEGER task, const std::string &name) {
+      if ( binary ) {
+        FileWriter out(trace);
+        TraceFormat::writeRecord(out, TraceFormat::TASK_BEGIN, task, 0, 0,
+                                 0, 0, name.c_str(), name.size());
+      } else {
+        fprintf(trace, "%ld B %s\n", task, name.c_str());
+      }
+    }
+
+    VOID receive(INTEGER task, const std::string &name, INTEGER parent) {
+      if ( binary ) {
+        FileWriter out(trace);
+        TraceFormat::writeRecord(out, TraceFormat::RECEIVE_TOKEN, task, 0,
+                                 parent);
+      } else {
+        fprintf(trace, "%ld C %s %ld\n", task, name.c_str(), parent);
+      }
+    }
+
+    VOID access(INTEGER task, BOOL isWrite, unsigned long addr,
+                INTEGER value, INTEGER lineNo, INTEGER funcId) {
+      if ( binary ) {
+        FileWriter out(trace);
+        TraceFormat::writeRecord(out,
+            isWrite ? TraceFormat::WRITE : TraceFormat::READ,
+            task, addr, value, lineNo, funcId);
+      } else {
+        fprintf(trace, "%ld %c 0x%lx %ld %ld %ld\n", task,
+                isWrite ? 'W' : 'R', addr, value, lineNo, funcId);
+      }
+    }
+
+    VOID end(INTEGER task, const std::string &name) {
+      if ( binary ) {
+        FileWriter out(trace);
+        TraceFormat::writeRecord(out, TraceFormat::TASK_END, task);
+      } else {
+        fprintf(trace, "%ld E %s\n", task, name.c_str());
+      }
+    }
+
+  private:
+    // the stream interface of TraceFormat over a FILE
+    struct FileWriter {
+      explicit FileWriter(FILE *file_): file(file_) {}
+      VOID write(const char *data, size_t size) {
+        fwrite(data, 1, size, file);
+      }
+      FILE *file;
+    };
+
+    FILE  *trace;
+    FILE  *hbLog;
+    BOOL   binary;
+};
+
+// Writes the IR of the task bodies. Line "line" of a body either
+// adds to the location it stores to, or stores what a call returns.
+static VOID writeIRlog(const GeneratorOptions &options,
+                       std::mt19937_64 &random, FILE *IRlog) {
+  std::uniform_real_distribution<double> share(0.0, 1.0);
+
+  for (unsigned body = 0; body < options.bodies; body++) {
+    fprintf(IRlog, "body%u\n", body);
+    for (unsigned line = 1; line <= options.lines; line++) {
+      if (share(random) < options.commute) {
+        fprintf(IRlog, "%u:   %%v%u = load i32, i32* %%x, align 4\n",
+                line, line);
+        fprintf(IRlog, "%u:   %%s%u = add nsw i32 %%v%u, 1\n",
+                line, line, line);
+        fprintf(IRlog, "%u:   store i32 %%s%u, i32* %%x, align 4\n",
+                line, line);
+      } else {
+        fprintf(IRlog, "%u:   %%c%u = call i32 @compute(i32* %%x)\n",
+                line, line);
+        fprintf(IRlog, "%u:   store i32 %%c%u, i32* %%x, align 4\n",
+                line, line);
+      }
+    }
+  }
+}
+
+static FILE *openOutput(const GeneratorOptions &options,
+                        const char *suffix) {
+  std::string fileName = std::string(options.prefix) + suffix;
+  FILE *file = fopen(fileName.c_str(), options.binary ? "wb" : "w");
+  if ( !file ) {
+    std::cout << "ERROR! " << fileName << " could not be written."
+              << std::endl;
+    exit(-1);
+  }
+  return file;
+}
+
+int main(int argc, char *argv[]) {
+  GeneratorOptions options;
+  if ( !parseOptions(argc, argv, options) ) {
+    printUsage();
+    exit(-1);
+  }
+
+  std::mt19937_64 random(options.seed);
+  std::uniform_real_distribution<double> share(0.0, 1.0);
+
+  std::vector<INTVECTOR> parents;
+  makeTaskGraph(options, random, parents);
+
+  FILE *trace = openOutput(options, "Tracelog.txt");
+  FILE *hbLog = openOutput(options, "HBlog.txt");
+  TraceWriter writer(trace, hbLog, options.binary);
+
+  for (INTEGER task = 0; task < static_cast<INTEGER>(parents.size());
+       task++) {
+    for (INTEGER parent : parents[task]) writer.edge(task, parent);
+  }
+
+  std::vector<std::string> bodyNames;
+  for (unsigned body = 0; body < options.bodies; body++) {
+    bodyNames.push_back("body" + std::to_string(body));
+    writer.function(body + 1, bodyNames.back()); // ids from 1
+  }
+
+  // walks the working set across the tasks
+  unsigned long next = 0;
+  uint64_t events = 0;
+  for (INTEGER task = 0; task < static_cast<INTEGER>(parents.size());
+       task++) {
+    unsigned body = random() % options.bodies;
+    const std::string &name = bodyNames[body];
+
+    writer.begin(task, name);
+    for (INTEGER parent : parents[task]) {
+      writer.receive(task, name, parent);
+    }
+    for (unsigned i = 0; i < options.accesses; i++) {
+      unsigned long addr;
+      if (share(random) < options.conflicts) {
+        addr = TRACEGEN_HOT_ADDRESS + (random() % options.hot) * 8;
+      } else {
+        addr = TRACEGEN_BASE_ADDRESS + next * 8;
+        next = (next + 1) % options.addresses;
+      }
+      BOOL isWrite = share(random) < options.writes;
+      INTEGER value  = isWrite ? random() % 1000000 : 0;
+      INTEGER lineNo = 1 + random() % options.lines;
+      writer.access(task, isWrite, addr, value, lineNo, body + 1);
+    }
+    writer.end(task, name);
+    events += options.accesses + parents[task].size() + 2;
+  }
+  fclose(trace);
+  fclose(hbLog);
+
+  FILE *IRlog = openOutput(options, "IRlog.txt");
+  writeIRlog(options, random, IRlog);
+  fclose(IRlog);
+
+  std::cout << "Generated " << parents.size() << " tasks, " << events
+            << " events (" << options.shape << ")" << std::endl;
+  return 0;
+}
@@ -23,7 +23,6 @@
 #include <fstream>
 #include <iostream>
 #include <map>
-#include <regex>
 #include <set>
 #include <sstream>
 #include <sstream>
@@ -68,6 +67,7 @@ enum OPERATION {
   MUL,
   DIV,
   SHL,
+  UNKNOWN,  // not used by the validator
 };
 
 static std::string OperRepresentation(OPERATION op) {
@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the compact binary format of the Tracelog and HBlog files.
+// A binary log starts with a FileHeader and is followed by fixed
+// size records. Records of task begin (B) and function (F) events
+// carry the task or function name as a payload right after the
+// record. Payloads are padded so that every record stays aligned.
+//
+// With DFINSPEC_TRACE_SHARDS=1 every thread writes its own shard of
+// the logs, and the Tracelog and HBlog are manifests: the line
+// TRACE_MANIFEST_MAGIC followed by the names of the shards, one per
+// line. In a Tracelog shard every task block starts with a sequence
+// event ("seq Q" in text, a Q record in binary) numbering the
+// blocks of all shards in the order the tasks ended.
+
+#ifndef _COMMON_TRACEFORMAT_HPP_
+#define _COMMON_TRACEFORMAT_HPP_
+
+#include "defs.hpp"
+#include <cstdint>
+#include <cstring>
+
+// the first line of a manifest of shards
+#define TRACE_MANIFEST_MAGIC "DFINSPEC-SHARDS 1"
+
+namespace TraceFormat {
+
+  const char      MAGIC[8]  = { 'D', 'F', 'I', 'N', 'S', 'P', 'E', 'C' };
+  const uint32_t  VERSION   = 1;
+  const uint32_t  BYTEORDER = 0x01020304;
+
+  // types of events stored in the binary log
+  enum RecordType : uint8_t {
+    TASK_BEGIN     =  'B',
+    TASK_END       =  'E',
+    RECEIVE_TOKEN  =  'C',
+    SEND_TOKEN     =  'S',
+    READ           =  'R',
+    WRITE          =  'W',
+    FUNCTION       =  'F',
+    TM_BEGIN       =  'T',  // BTM in the text log
+    TM_END         =  't',  // ETM in the text log
+    HB_EDGE        =  'H',  // a line of the HBlog
+    SEQUENCE       =  'Q',  // a task block of a shard begins
+  };
+
+  typedef struct FileHeader {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  byteOrder;
+    uint32_t  recordSize;
+    uint32_t  reserved;
+
+    FileHeader() {
+      memcpy(magic, MAGIC, sizeof(magic));
+      version    = VERSION;
+      byteOrder  = BYTEORDER;
+      recordSize = 0;
+      reserved   = 0;
+    }
+  } FileHeader;
+
+  // A single event. Fields not used by an event are zero:
+  //   R/W: taskId, addr, value, lineNo, funcId
+  //   C:   taskId, value (the parent task id)
+  //   H:   taskId, value (the parent task id)
+  //   Q:   taskId, value (the sequence number of the block)
+  //   F:   funcId, payload (function name)
+  //   B:   taskId, payload (task name)
+  //   E/S/T/t: taskId
+  typedef struct Record {
+    uint8_t   type;
+    uint8_t   reserved[3];
+    uint32_t  payloadSize;  // bytes of name following the record
+    int64_t   taskId;
+    uint64_t  addr;
+    int64_t   value;
+    int32_t   lineNo;
+    int32_t   funcId;
+  } Record;
+
+  /** Returns the payload size rounded up to keep records aligned */
+  inline size_t paddedSize(size_t payloadSize) {
+    return (payloadSize + 7) & ~static_cast<size_t>(7);
+  }
+
+  /** Checks whether the file header describes a supported log */
+  inline bool isValidHeader(const FileHeader &header) {
+    return memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+           header.version    == VERSION &&
+           header.byteOrder  == BYTEORDER &&
+           header.recordSize == sizeof(Record);
+  }
+
+  /** Appends the file header to an output stream */
+  template <typename StreamT>
+  inline void writeHeader(StreamT &out) {
+    FileHeader header;
+    header.recordSize = sizeof(Record);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+
+  /** Appends a record and its (padded) payload to an output stream */
+  template <typename StreamT>
+  inline void writeRecord(StreamT &out, RecordType type,
+                          int64_t taskId, uint64_t addr = 0,
+                          int64_t value = 0, int32_t lineNo = 0,
+                          int32_t funcId = 0,
+                          const char *payload = NULL,
+                          uint32_t payloadSize = 0) {
+    Record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type        = type;
+    rec.payloadSize = payloadSize;
+    rec.taskId      = taskId;
+    rec.addr        = addr;
+    rec.value       = value;
+    rec.lineNo      = lineNo;
+    rec.funcId      = funcId;
+    out.write(reinterpret_cast<const char *>(&rec), sizeof(rec));
+
+    if ( payloadSize ) {
+      static const char zeros[8] = { 0 };
+      out.write(payload, payloadSize);
+      out.write(zeros, paddedSize(payloadSize) - payloadSize);
+    }
+  }
+
+} // end namespace
+
+#endif // end traceFormat.hpp
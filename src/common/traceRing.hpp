@@ -0,0 +1,324 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the ring of events shared by a running program and
+// DFchecker through a memory mapped file (DFINSPEC_STREAM=ring:PATH,
+// e.g. under /dev/shm). The file holds a RingHeader in its first
+// pages, followed by the events. Tasks copy their events straight
+// into the mapping, and the checker reads them in place. The pages
+// belong to the file, so the events committed by a program which
+// crashes are still there for a checker started later.
+//
+// The ring is mapped twice in a row, so an event which wraps
+// around the end is contiguous in memory. Writers claim space by
+// advancing "reserved" and publish it in the order they claimed it
+// by advancing "committed"; the checker frees it by advancing
+// "consumed". A writer waits while the ring is full.
+//
+// The writer is known by its pid and the time its process started,
+// so a ring left by a program whose pid was reused since is seen
+// as the ring of a program which died.
+
+#ifndef _COMMON_TRACERING_HPP_
+#define _COMMON_TRACERING_HPP_
+
+#include "defs.hpp"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// the prefix of ring stream names
+#define TRACE_RING_PREFIX     "ring:"
+
+// the bytes of the ring if DFINSPEC_RING_BYTES is not set
+#define TRACE_RING_BYTES      (64UL << 20)
+
+// the pause of a waiting writer or reader
+#define TRACE_RING_WAIT_US    200
+
+namespace TraceRing {
+
+  const char      MAGIC[8]     = { 'D', 'F', 'R', 'I', 'N', 'G', '0', '2' };
+
+  typedef struct RingHeader {
+    char                   magic[8];
+    uint64_t               headerBytes; // whole pages, the events follow
+    uint64_t               capacity;    // bytes, a power of two
+    int64_t                writerPid;   // to tell a crashed program
+    uint64_t               writerStart; // of its process, 0 if unknown
+    std::atomic<uint32_t>  finished;    // the program finalized
+
+    // on their own cache lines, written by different processes
+    alignas(64) std::atomic<uint64_t>  reserved;
+    alignas(64) std::atomic<uint64_t>  committed;
+    alignas(64) std::atomic<uint64_t>  consumed;
+  } RingHeader;
+
+  /** The bytes of the header: the pages which hold a RingHeader */
+  inline size_t headerBytes() {
+    size_t page = sysconf(_SC_PAGESIZE);
+    return (sizeof(RingHeader) + page - 1) / page * page;
+  }
+
+  /**
+   * The time process "pid" started, in clock ticks after the boot
+   * (the 22nd field of /proc/pid/stat); 0 if it is not known.
+   */
+  inline uint64_t processStart(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%ld/stat", static_cast<long>(pid));
+    FILE *stat = fopen(path, "r");
+    if ( !stat ) return 0;
+
+    char line[1024];
+    size_t length = fread(line, 1, sizeof(line) - 1, stat);
+    fclose(stat);
+    line[length] = '\0';
+
+    // the fields follow the command name, which may hold spaces
+    const char *pos = strrchr(line, ')');
+    unsigned long long start = 0;
+    if (!pos || sscanf(pos + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u "
+                       "%*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+                       &start) != 1) {
+      return 0;
+    }
+    return start;
+  }
+
+  inline VOID waitABit() {
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(TRACE_RING_WAIT_US));
+  }
+
+} // end namespace
+
+class SharedRing {
+  public:
+    SharedRing(): header(NULL), data(NULL), headerBytes(0), capacity(0) {}
+    ~SharedRing() { close(); }
+
+    inline bool is_open() const { return header != NULL; }
+
+    /**
+     * Creates the ring file "path" of at least "bytes" for the
+     * events, replacing an earlier one once it is ready.
+     */
+    bool create(const std::string &path, size_t bytes) {
+      close();
+      size_t page = sysconf(_SC_PAGESIZE);
+      headerBytes = TraceRing::headerBytes();
+      capacity    = page;
+      while (capacity < bytes) capacity <<= 1;
+
+      std::string temporary = path + ".tmp";
+      int fd = ::open(temporary.c_str(),
+                      O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0) return false;
+      if (ftruncate(fd, headerBytes + capacity) != 0 ||
+          !map(fd)) {
+        ::close(fd);
+        unlink(temporary.c_str());
+        return false;
+      }
+      ::close(fd);
+
+      new (header) TraceRing::RingHeader();
+      memcpy(header->magic, TraceRing::MAGIC, sizeof(TraceRing::MAGIC));
+      header->headerBytes = headerBytes;
+      header->capacity    = capacity;
+      header->writerPid   = getpid();
+      header->writerStart = TraceRing::processStart(getpid());
+      header->finished    = 0;
+      header->reserved    = 0;
+      header->committed   = 0;
+      header->consumed    = 0;
+
+      if (rename(temporary.c_str(), path.c_str()) != 0) {
+        close();
+        unlink(temporary.c_str());
+        return false;
+      }
+      return true;
+    }
+
+    /** Maps the existing ring file "path" */
+    bool open(const std::string &path) {
+      close();
+      int fd = ::open(path.c_str(), O_RDWR);
+      if (fd < 0) return false;
+
+      // the header is mapped at the page size of the writer
+      TraceRing::RingHeader probe;
+      struct stat info;
+      size_t page = sysconf(_SC_PAGESIZE);
+      bool valid =
+          pread(fd, &probe, sizeof(probe), 0) ==
+              static_cast<ssize_t>(sizeof(probe)) &&
+          memcmp(probe.magic, TraceRing::MAGIC,
+                 sizeof(TraceRing::MAGIC)) == 0 &&
+          probe.headerBytes >= sizeof(probe) &&
+          probe.headerBytes % page == 0 &&
+          probe.capacity % page == 0 &&
+          fstat(fd, &info) == 0 &&
+          static_cast<uint64_t>(info.st_size) ==
+              probe.headerBytes + probe.capacity;
+
+      headerBytes = valid ? probe.headerBytes : 0;
+      capacity    = valid ? probe.capacity : 0;
+      valid = valid && map(fd);
+      ::close(fd);
+      return valid;
+    }
+
+    /**
+     * Appends "size" bytes which "copy(destination, bytes)" writes
+     * in order. Blocks of any size keep their order in the ring.
+     */
+    template <typename Copy>
+    VOID push(size_t size, Copy copy) {
+      if ( !size ) return;
+      uint64_t begin = header->reserved.fetch_add(size);
+
+      if (size <= capacity) {
+        waitForSpace(begin + size);
+        copy(at(begin), size);
+        waitForCommits(begin);
+        header->committed.store(begin + size, std::memory_order_release);
+        return;
+      }
+
+      // larger than the ring: written in parts once the earlier
+      // blocks are committed, each part committed on its own
+      waitForCommits(begin);
+      for (uint64_t pos = begin; pos < begin + size; ) {
+        size_t part = std::min<uint64_t>(capacity / 2, begin + size - pos);
+        waitForSpace(pos + part);
+        copy(at(pos), part);
+        pos += part;
+        header->committed.store(pos, std::memory_order_release);
+      }
+    }
+
+    /** Appends "size" bytes of "bytes" */
+    VOID write(const char *bytes, size_t size) {
+      push(size, [&bytes](char *destination, size_t count) {
+        memcpy(destination, bytes, count);
+        bytes += count;
+      });
+    }
+
+    /** Tells the reader that no more events come */
+    VOID finish() {
+      if ( header ) header->finished.store(1, std::memory_order_release);
+    }
+
+    /** The events in [consumed(), committed()) are to be read */
+    inline uint64_t committed() const {
+      return header->committed.load(std::memory_order_acquire);
+    }
+    inline uint64_t consumed() const {
+      return header->consumed.load(std::memory_order_relaxed);
+    }
+
+    /** Frees the events before "position" for the writers */
+    inline VOID consume(uint64_t position) {
+      header->consumed.store(position, std::memory_order_release);
+    }
+
+    /** The event at "position", contiguous up to a ring size */
+    inline char *at(uint64_t position) const {
+      return data + (position & (capacity - 1));
+    }
+
+    /**
+     * True once the program finished or died, also if its pid is
+     * now taken by a process which started at another time.
+     */
+    bool writerDone() const {
+      if ( header->finished.load(std::memory_order_acquire) ) return true;
+      pid_t pid = static_cast<pid_t>(header->writerPid);
+      if (kill(pid, 0) != 0 && errno == ESRCH) return true;
+
+      uint64_t start = TraceRing::processStart(pid);
+      return header->writerStart && start && start != header->writerStart;
+    }
+
+    VOID close() {
+      if ( header ) {
+        munmap(header, headerBytes + 2 * capacity);
+      }
+      header = NULL;
+      data   = NULL;
+    }
+
+  private:
+    SharedRing(const SharedRing &);
+    SharedRing &operator=(const SharedRing &);
+
+    // maps the header and the ring, then the ring again after it
+    bool map(int fd) {
+      size_t total = headerBytes + 2 * capacity;
+      void *area = mmap(NULL, total, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (area == MAP_FAILED) return false;
+
+      char *first = static_cast<char *>(area);
+      char *ring  = first + headerBytes;
+      if (mmap(first, headerBytes + capacity,
+               PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+               fd, 0) == MAP_FAILED ||
+          mmap(ring + capacity, capacity, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_FIXED, fd,
+               headerBytes) == MAP_FAILED) {
+        munmap(area, total);
+        return false;
+      }
+
+      header = reinterpret_cast<TraceRing::RingHeader *>(first);
+      data   = ring;
+      return true;
+    }
+
+    // until the reader consumed what "end" overwrites
+    inline VOID waitForSpace(uint64_t end) {
+      while (end - header->consumed.load(std::memory_order_acquire) >
+             capacity) {
+        TraceRing::waitABit();
+      }
+    }
+
+    // until the blocks claimed before "begin" are committed
+    inline VOID waitForCommits(uint64_t begin) {
+      while (header->committed.load(std::memory_order_acquire) != begin) {
+        std::this_thread::yield();
+      }
+    }
+
+    TraceRing::RingHeader  *header;
+    char                   *data;
+    uint64_t                headerBytes;
+    uint64_t                capacity;
+};
+
+#endif // end traceRing.hpp
@@ -0,0 +1,137 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements the reader of the binary Tracelog and HBlog files.
+
+#include "binaryTrace.hpp"
+
+BOOL BinaryTraceReader::isBinaryLog(const char *logName) {
+  FILE *log = fopen(logName, "rb");
+  if ( !log ) return false;
+
+  TraceFormat::FileHeader header;
+  size_t count = fread(&header, sizeof(header), 1, log);
+  fclose(log);
+
+  return count == 1 &&
+         memcmp(header.magic, TraceFormat::MAGIC,
+                sizeof(TraceFormat::MAGIC)) == 0;
+}
+
+BOOL BinaryTraceReader::readHBlog(const char *logName,
+                                  Checker &checker) {
+  return readRecords(logName, checker, false);
+}
+
+BOOL BinaryTraceReader::readTrace(const char *logName,
+                                  Checker &checker) {
+  return readRecords(logName, checker, true);
+}
+
+BOOL BinaryTraceReader::readRecords(const char *logName,
+                                    Checker &checker, BOOL isTrace) {
+  MappedFile log;
+  if ( !log.open(logName) ) return false;
+
+  const TraceFormat::FileHeader *header =
+      reinterpret_cast<const TraceFormat::FileHeader *>(log.begin());
+  if (log.size() < sizeof(TraceFormat::FileHeader) ||
+      !TraceFormat::isValidHeader(*header)) {
+    std::cout << "ERROR!" << std::endl;
+    std::cout << "Unsupported binary log: " << logName << std::endl;
+    return false;
+  }
+
+  const char *pos = log.begin() + sizeof(TraceFormat::FileHeader);
+  size_t offset = 0;
+  if (isTrace &&
+      !checker.resumeOffset(log.begin(), log.size(), offset)) {
+    return false;
+  }
+  pos = std::max(pos, log.begin() + offset);
+  pos += processRecords(pos, log.end(), checker,
+                        isTrace ? log.begin() : NULL);
+
+  if (pos != log.end()) {
+    std::cout << "Warning: truncated binary log " << logName
+              << std::endl;
+  }
+  return true;
+}
+
+size_t BinaryTraceReader::processRecords(const char *pos,
+                                         const char *end,
+                                         Checker &checker,
+                                         const char *trace) {
+  const char *first = pos;
+  while (static_cast<size_t>(end - pos) >= sizeof(TraceFormat::Record)) {
+    const TraceFormat::Record *rec =
+        reinterpret_cast<const TraceFormat::Record *>(pos);
+    size_t size = sizeof(TraceFormat::Record) +
+                  TraceFormat::paddedSize(rec->payloadSize);
+    if (static_cast<size_t>(end - pos) < size) break; // not complete
+
+    processRecord(*rec, pos + sizeof(TraceFormat::Record), checker);
+    pos += size;
+
+    if (trace && checker.checkpointDue()) {
+      checker.saveCheckpoint(trace, pos - trace);
+    }
+  }
+  return pos - first;
+}
+
+VOID BinaryTraceReader::processRecord(const TraceFormat::Record &rec,
+                                      const char *payload,
+                                      Checker &checker) {
+  switch ( rec.type ) {
+    case TraceFormat::READ:
+    case TraceFormat::WRITE: {
+      Action action;
+      action.taskId  = rec.taskId;
+      action.addr    = reinterpret_cast<ADDRESS>(rec.addr);
+      action.value   = rec.value;
+      action.lineNo  = rec.lineNo;
+      action.funcId  = rec.funcId;
+      action.isWrite = (rec.type == TraceFormat::WRITE);
+
+      if (action.funcId == 0) {
+        std::cout << "Warning function Id 0: task "
+                  << rec.taskId << std::endl;
+        exit(0);
+      }
+
+      MemoryActions memActions( action );
+      checker.saveTaskActions( memActions );
+      break;
+    }
+    case TraceFormat::TASK_BEGIN:
+      name.assign(payload, rec.payloadSize);
+      checker.beginTask(rec.taskId, name);
+      break;
+    case TraceFormat::FUNCTION:
+      name.assign(payload, rec.payloadSize);
+      checker.registerFunction(rec.funcId, name);
+      break;
+    case TraceFormat::HB_EDGE:
+      checker.addTaskEdge(rec.taskId, rec.value);
+      break;
+    case TraceFormat::RECEIVE_TOKEN:
+      checker.receiveToken(rec.taskId, rec.value);
+      break;
+    case TraceFormat::TASK_END:
+      checker.endTask();
+      break;
+    default: // events not used for checking
+      break;
+  }
+}
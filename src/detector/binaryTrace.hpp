@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the reader of the binary Tracelog and HBlog files.
+// The records are decoded in place and passed to the checker
+// through its typed events, no string is built per record.
+
+#ifndef _DETECTOR_BINARYTRACE_HPP_
+#define _DETECTOR_BINARYTRACE_HPP_
+
+#include "checker.hpp"
+#include "mappedFile.hpp"
+#include "traceFormat.hpp"
+#include <cstdio>
+
+class BinaryTraceReader {
+  public:
+    /** Returns true if the log file starts with a binary header */
+    static BOOL isBinaryLog(const char *logName);
+
+    /** Reads the happens-before edges of a binary HBlog */
+    BOOL readHBlog(const char *logName, Checker &checker);
+
+    /** Reads the events of a binary Tracelog */
+    BOOL readTrace(const char *logName, Checker &checker);
+
+    /**
+     * Processes the records in [pos, end) which follow the header.
+     * Returns the number of bytes consumed; an incomplete record
+     * at the end is left for the next call. Snapshots are taken
+     * if "trace", where the file begins, is given.
+     */
+    size_t processRecords(const char *pos, const char *end,
+                          Checker &checker, const char *trace = NULL);
+
+  private:
+    // decodes one record and its payload
+    VOID processRecord(const TraceFormat::Record &rec,
+                       const char *payload, Checker &checker);
+
+    // calls processRecord for every record of the log, from the
+    // snapshot resumed for a trace
+    BOOL readRecords(const char *logName, Checker &checker,
+                     BOOL isTrace);
+
+    // reused for task and function names
+    std::string name;
+};
+
+#endif // end binaryTrace.hpp
@@ -17,9 +17,93 @@
 #include "MemoryActions.hpp"
 
 #define VERBOSE
-#define CONC_THREASHOLD 5
+
+// actions queued before the shards are checked in parallel
+#define PENDING_BATCH_SIZE (1 << 16)
+
+// a single thread times one check in this many (--profile), as
+// timing every check would slow them down by a fourth
+#define CHECK_TIMING_SAMPLE 16
+
+// the nanoseconds elapsed since "begin"
+static inline uint64_t nanosSince(
+    std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - begin ).count();
+}
+
+Checker::Checker(const CheckerOptions &options, NameInterner &names_)
+    : hbEngine( HBEngine::create(options.hbEngine) ),
+      exactHistory( options.exact ),
+      historyDepth( options.exact ? 0 : options.historyDepth ),
+      maxConflicts( options.maxConflicts ),
+      online( options.stream != NULL ), openTask(-1),
+      pendingCount(0), events(0), accesses(0), peakLiveTasks(0),
+      conflictsFound(0), profiled( options.profile != NULL ),
+      checkNanos(0), engineKind( options.hbEngine ),
+      checkpointName( options.checkpoint ? options.checkpoint : "" ),
+      checkpointEvery( options.checkpointEvery ),
+      nextCheckpoint( options.checkpointEvery ), checkpointReady(false),
+      resumed(false),
+      names(names_), signatureManager(names_) {
+  for (unsigned i = 0; i < options.threads; i++) {
+    shards.emplace_back( historyDepth );
+  }
+  if (options.threads > 1) {
+    pool.reset( new ThreadPool(options.threads) );
+  }
+}
 
 void Checker::saveTaskActions( const MemoryActions &taskActions ) {
+  if (openTask >= 0) beginOpenTask(); // online, its first action
+  events++;
+  accesses++;
+  AccessRecord access( taskActions.action );
+  if ( !pool ) { // a single thread checks immediately
+    BOOL timed = profiled && accesses % CHECK_TIMING_SAMPLE == 0;
+    std::chrono::steady_clock::time_point begin;
+    if ( timed ) begin = std::chrono::steady_clock::now();
+    if ( exactHistory ) {
+      checkAccessExact(shards[0], taskActions.addr, access);
+    } else {
+      checkAccess(shards[0], taskActions.addr, access);
+    }
+    if ( timed ) checkNanos += nanosSince(begin) * CHECK_TIMING_SAMPLE;
+    return;
+  }
+
+  PendingAccess pendingAccess = { taskActions.addr, access };
+  shards[ shardOf(taskActions.addr) ].pending.push_back( pendingAccess );
+  pendingTasks.insert( taskActions.taskId );
+  if (++pendingCount >= PENDING_BATCH_SIZE) {
+    flushPendingActions();
+  }
+}
+
+VOID Checker::flushPendingActions() {
+  if ( !pendingCount ) return;
+  auto begin = std::chrono::steady_clock::now();
+
+  // the HB engine and the graph do not change while the shards run
+  pool->run(shards.size(), [this](size_t index) {
+    CheckerShard &shard = shards[index];
+    for (const auto &pendingAccess : shard.pending) {
+      if ( exactHistory ) {
+        checkAccessExact(shard, pendingAccess.addr, pendingAccess.access);
+      } else {
+        checkAccess(shard, pendingAccess.addr, pendingAccess.access);
+      }
+    }
+    shard.pending.clear();
+  });
+
+  pendingTasks.clear();
+  pendingCount = 0;
+  checkNanos += nanosSince(begin);
+}
+
+VOID Checker::checkAccess(CheckerShard &shard, ADDRESS addr,
+                          const AccessRecord &access) {
 
   // CASES
   // 1. first action -> just save
@@ -31,288 +115,299 @@ void Checker::saveTaskActions( const MemoryActions &taskActions ) {
   //        write in the parallel writes,update and take it forward
   //        4.2.1 check conflicts with other parallel tasks
 
-  auto perAddrActions = writes.find( taskActions.addr );
-  if (perAddrActions == writes.end()) { // 1. first action
-     writes[taskActions.addr] = std::list<MemoryActions>();
-  }
+  // 1. first action creates the history
+  ShadowMemory::History AddrActions = shard.writes.history(addr);
 
-  std::list<MemoryActions> &AddrActions = writes[taskActions.addr];
-  for (auto& lastWrt : AddrActions) {
-    // actions of same task
-    if ( taskActions.taskId == lastWrt.taskId) continue;
+  for (size_t i = 0; i < AddrActions.size(); i++) {
+    const AccessRecord &lastWrt = AddrActions[i];
 
-    auto HBfound =
-        serial_bags[ taskActions.taskId ]->HB.find(lastWrt.taskId);
-    auto end = serial_bags[taskActions.taskId]->HB.end();
+    // actions of same task
+    if ( access.taskId == lastWrt.taskId) continue;
 
-    if (HBfound != end) continue; // 3. there's happens-before
+    // 3. there's happens-before
+    if (hbEngine->happensBefore(lastWrt.taskId, access.taskId)) {
+      continue;
+    }
 
     // 4. parallel, possible race! ((check race))
 
     // check write-write case (different values written)
     // 4.1 both write to shared memory
-    if ( (taskActions.action.isWrite && lastWrt.action.isWrite) &&
-       (taskActions.action.value != lastWrt.action.value) ) {
+    if ( (access.isWrite && lastWrt.isWrite) &&
+       (access.value != lastWrt.value) ) {
          // write different values
       // code for recording errors
-      saveNondeterminismReport( taskActions.action, lastWrt.action );
+      saveNondeterminismReport(shard, addr, access, lastWrt);
     }
     // 4.2 read-after-write or write-after-read conflicts
-    // (a) taskActions is read-only and lastWrt is a writer
-    else if ( (!taskActions.action.isWrite)
-            &&  lastWrt.action.isWrite ) {
+    // (a) access is read-only and lastWrt is a writer
+    else if ( (!access.isWrite) && lastWrt.isWrite ) {
       // code for recording errors
-      saveNondeterminismReport(taskActions.action, lastWrt.action);
+      saveNondeterminismReport(shard, addr, access, lastWrt);
     }
-    // (b) lastWrt is read-only and taskActions is a writer
-    else if ( (!lastWrt.action.isWrite)
-            &&  taskActions.action.isWrite ) {
+    // (b) lastWrt is read-only and access is a writer
+    else if ( (!lastWrt.isWrite) && access.isWrite ) {
             // the other task is writer.
       // code for recording errors
-      saveNondeterminismReport(taskActions.action, lastWrt.action);
+      saveNondeterminismReport(shard, addr, access, lastWrt);
     }
   }
 
-  if (AddrActions.size() >= CONC_THREASHOLD) {
-    AddrActions.pop_front(); // remove oldest element
-  }
-  writes[taskActions.addr].push_back( taskActions ); // save
+  // save, the oldest access is dropped once the history is full
+  AddrActions.push( access );
 }
 
-
-/**
- * Records the nondeterminism warning to the conflicts table.
- * This is per pair of concurrent tasks.
- */
-VOID Checker::saveNondeterminismReport(const Action &curMemAction,
-                                       const Action &prevMemAction) {
-  Conflict report(curMemAction, prevMemAction);
-  // code for recording errors
-  const char *task1Name = graph[curMemAction.taskId].name.c_str();
-  const char *task2Name = graph[prevMemAction.taskId].name.c_str();
-
-  auto taskPair = std::make_pair(task1Name, task2Name);
-  if (conflictTable.find(taskPair) != conflictTable.end()) {// exists
-    conflictTable[taskPair].buggyAccesses.insert( report );
-  } else { // add new
-    conflictTable[taskPair] = Report();
-    conflictTable[taskPair].task1Name = graph[curMemAction.taskId].name;
-    conflictTable[taskPair].task2Name = graph[prevMemAction.taskId].name;
-    conflictTable[taskPair].buggyAccesses.insert( report );
+VOID Checker::checkAccessExact(CheckerShard &shard, ADDRESS addr,
+                               const AccessRecord &access) {
+  size_t index = shard.writes.addressIndex(addr);
+  if (index >= shard.summaries.size()) {
+    shard.summaries.resize(index + 1);
   }
-}
-
+  AccessSummary &summary = shard.summaries[index];
 
-// Adds a new task node in the simple happens-before graph
-// @params: logLine, a log entry the contains the task ids
-void Checker::addTaskNode(std::string &logLine) {
-    std::stringstream ssin(logLine);
-    int sibId;
-    int parId;
-
-    ssin >> sibId;
-    ssin >> parId;
-    //cout << line << "(" << sibId << " " << parId << ")" << std::endl;
-
-    if (graph.find(parId) == graph.end())
-      graph[parId] = Task();
+  // 1. check against the writes, and the reads if a writer
+  for (const auto &write : summary.writes) {
+    if ( conflicting(access, write.access) ) {
+      saveNondeterminismReport(shard, addr, access, write.access);
+    }
+  }
+  if ( access.isWrite ) {
+    for (const auto &read : summary.reads) {
+      if ( conflicting(access, read) ) {
+        saveNondeterminismReport(shard, addr, access, read);
+      }
+    }
+  }
 
-    if (graph.find(sibId) == graph.end())
-      graph[sibId] = Task();
+  // 2. a read stands for the reads ordered before it
+  if ( !access.isWrite ) {
+    std::vector<AccessRecord> &reads = summary.reads;
+    size_t kept = 0;
+    for (size_t i = 0; i < reads.size(); i++) {
+      if ( !ordered(reads[i], access) ) reads[kept++] = reads[i];
+    }
+    reads.resize(kept);
+    reads.push_back( access );
+    return;
+  }
 
-    graph[parId].outEdges.insert(sibId);
-    graph[sibId].inEdges.insert(parId);
+  // 3. a write ordered before the new one is dropped once later
+  // writes stand for it: one of the same value, or two of different
+  // values, so an access racing with it races with one of them
+  std::vector<SummaryWrite> &writes = summary.writes;
+  size_t kept = 0;
+  for (size_t i = 0; i < writes.size(); i++) {
+    SummaryWrite &prev = writes[i];
+    if ( ordered(prev.access, access) ) {
+      if (prev.access.value == access.value) continue;
+      if (prev.overwritten && prev.laterValue != access.value) continue;
+      prev.overwritten = true;
+      prev.laterValue  = access.value;
+    }
+    writes[kept++] = prev;
+  }
+  writes.resize(kept);
+  writes.push_back( SummaryWrite(access) );
 }
 
-/** Constructs action object from the log file */
-void Checker::constructMemoryAction(
-    std::stringstream &ssin,
-    std::string &operation,
-    Action &action) {
-
-    std::string tempBuff;
-    ssin >> tempBuff; // address
-    action.addr = (ADDRESS)stoul(tempBuff, 0, 16);
 
-    ssin >> tempBuff; // value
-    action.value = stol(tempBuff);
+/**
+ * Records the nondeterminism warning to the conflicts table
+ * of the shard. This is per pair of concurrent tasks.
+ */
+VOID Checker::saveNondeterminismReport(CheckerShard &shard, ADDRESS addr,
+                                       const AccessRecord &curMemAction,
+                                       const AccessRecord &prevMemAction) {
+  shard.racyAddresses[ reinterpret_cast<uint64_t>(addr) ] = true;
 
-    ssin >> tempBuff; // line number
-    action.lineNo = stol(tempBuff);
+  // code for recording errors
+  uint64_t taskPair = packPair(curMemAction.taskId, prevMemAction.taskId);
+  Report *found = shard.conflictTable.find(taskPair);
+  if ( !found ) { // add new
+    found            = &shard.conflictTable[taskPair];
+    found->task1Name = graph.name(curMemAction.taskId);
+    found->task2Name = graph.name(prevMemAction.taskId);
+  }
 
-    ssin >> action.funcId; // get function id
+  // counted, but not kept once the pair has enough
+  found->conflicts++;
+  if ( !found->keeps(curMemAction.lineNo, prevMemAction.lineNo,
+                     maxConflicts) ) {
+    return;
+  }
+  found->buggyAccesses.insert( Conflict(curMemAction.toAction(addr),
+                                        prevMemAction.toAction(addr)) );
+}
 
-    if (operation == "W") {
-      action.isWrite = true;
-    } else {
-      action.isWrite = false;
+/**
+ * Moves the conflicts of the shards to the conflicts table.
+ * The shards are merged in order and the pairs of tasks are
+ * sorted, so the result does not depend on the number of threads
+ * which checked them.
+ */
+VOID Checker::mergeShardReports() {
+  for (auto &shard : shards) {
+    for (auto &entry : shard.conflictTable) {
+      conflictsFound += entry.second.conflicts;
+      Report *found = conflictTable.find(entry.first);
+      if ( !found ) {
+        conflictTable[entry.first] = std::move(entry.second);
+      } else {
+        found->conflicts += entry.second.conflicts;
+        for (const auto &conflict : entry.second.buggyAccesses) {
+          if ( found->keeps(conflict.action1.lineNo,
+                            conflict.action2.lineNo, maxConflicts) ) {
+            found->buggyAccesses.insert( conflict );
+          }
+        }
+      }
     }
+    shard.conflictTable.clear();
+  }
+  conflictTable.sortByKey();
 
-#ifdef DEBUG // check if data correctly set.
-    std::cout << "Action constructed: ";
-    std::ostringstream buff;
-    action.printAction(buff);
-    std::cout << buff.str() << std::endl;
-#endif
+  // the same order for any number of shards
+  for (auto &entry : conflictTable) entry.second.buggyAccesses.sort();
 }
 
-void Checker::processLogLines(std::string &line) {
-
-  std::stringstream ssin(line); // split string
-
-  int taskID;
-  std::string taskName;
-  std::string operation;
+// Adds the edge parId --> sibId in the simple happens-before graph
+VOID Checker::addTaskEdge(INTEGER sibId, INTEGER parId) {
+  events++;
+  graph.addEdge(sibId, parId);
+}
 
-  ssin >> taskID; // get task id
-  ssin >> operation; // get operation
+// Saves the name of a function executed by the tasks
+VOID Checker::registerFunction(INTEGER funcID,
+                               const std::string &funcName) {
+  events++;
+  signatureManager.addFuncName(funcName, funcID);
+}
 
-  if (operation.find("W") != std::string::npos || // write action, or
-      operation.find("R") != std::string::npos) { // read action
-    Action action;
-    action.taskId = taskID;
-    constructMemoryAction(ssin, operation, action);
+// Registers a task which begins in the happens-before engine.
+// All parents of the task have terminated at this point.
+VOID Checker::beginTask(INTEGER taskID, const std::string &taskName) {
+  events++;
+  if ( online ) { // the parents follow in the token receive events
+    beginOpenTask();
+    openTask     = taskID;
+    openTaskName = taskName;
+    openParents.clear();
+    return;
+  }
 
-    if (action.funcId == 0) {
-     std::cout << "Warning function Id 0: " << line << std::endl;
-     exit(0);
-    }
+  graph.addTask(taskID); // put it in the simple HB graph
+  TaskGraph::Range inEdges = graph.parents(taskID);
 
-    MemoryActions memActions( action ); // save first action
-
-    if ( !ssin.eof() ) { // there are still tokens
-      std::string separator;
-      ssin >> separator;
-      ssin >> taskID;
-      Action lastWAction;
-      lastWAction.taskId = taskID;
-      ssin >> operation;
-      constructMemoryAction(ssin, operation, lastWAction);
-      memActions.storeAction( lastWAction ); // save second action
-    }
+  // we already know its parents and the tasks depending on it
+  INTVECTOR parents(inEdges.begin(), inEdges.end());
+  startTask(taskID, taskName, parents, graph.children(taskID).size());
+}
 
-    saveTaskActions( memActions ); // save the actions
-  } else if (operation.find("F") != std::string::npos) {
-  // Check if this is just function name
+// Online, a token received from "parentID" is an edge of the task
+VOID Checker::receiveToken(INTEGER taskID, INTEGER parentID) {
+  events++;
+  if (online && taskID == openTask) {
+    openParents.push_back(parentID);
+  }
+}
 
-    // task id position is func ID in this case
-    int funcID = taskID;
+// A task ended. Online, a task without accesses begins here; a
+// snapshot is due once enough events were read.
+VOID Checker::endTask() {
+  events++;
+  if ( online ) beginOpenTask();
+  checkpointReady = !checkpointName.empty() && events >= nextCheckpoint;
+}
 
-    std::string funcName;
-    getline(ssin, funcName); // get function name
+// Begins the task whose parents were collected online
+VOID Checker::beginOpenTask() {
+  if (openTask < 0) return;
+  INTEGER taskID = openTask;
+  openTask = -1;
 
-    // save the function name
-    signatureManager.addFuncName(funcName, funcID);
-  } else if (operation.find("B") != std::string::npos) {
-  // if new task creation, parents terminated
+  std::sort(openParents.begin(), openParents.end());
+  openParents.erase(std::unique(openParents.begin(), openParents.end()),
+                    openParents.end());
 
-    ssin >> taskName; // get task name
+  graph.addTask(taskID);
+  for (auto parent : openParents) graph.addEdge(taskID, parent);
 
-    // we already know its parents
-    // use this information to inherit or greate new serial bag
-    auto parentTasks = graph[taskID].inEdges.begin();
-    if (parentTasks == graph[taskID].inEdges.end()) { // if no HB tasks in graph
+  // the children are not known yet, the HB state is never released
+  startTask(taskID, openTaskName, openParents, 0);
+}
 
-      // check if has no serial bag
-      if (serial_bags.find(taskID) == serial_bags.end()) {
-        auto newTaskbag = new SerialBag();
-        if (graph.find(taskID) != graph.end()) {
-          // specify number of tasks dependent of this task
-          newTaskbag->outBufferCount = graph[taskID].outEdges.size();
-        } else { //put it in the simple HB graph
-          graph[taskID] = Task();
-        }
-        graph[taskID].name = taskName; // save the name of the task
-        serial_bags[taskID] = newTaskbag;
+VOID Checker::startTask(INTEGER taskID, const std::string &taskName,
+                        const INTVECTOR &parents, INTEGER outDegree) {
+  // the HB state of the parents changes below, queued actions
+  // of the parents are checked with the state as it is now
+  if ( pendingCount ) {
+    for (auto parent : parents) {
+      if ( pendingTasks.count(parent) ) {
+        flushPendingActions();
+        break;
       }
     }
-    else { // has parent tasks
-      // look for the parents serial bags and inherit them
-      // or construct your own by cloning the parent's
-
-      // 1.find the parent bag which can be inherited
-      SerialBagPtr taskBag = NULL;
-      auto inEdge = graph[taskID].inEdges.begin();
-      for (; inEdge != graph[taskID].inEdges.end(); inEdge++) {
-
-        // take with outstr 1 and longest
-        auto curBag = serial_bags[*inEdge];
-        if (curBag->outBufferCount == 1) {
-          serial_bags.erase(*inEdge);
-          graph[taskID].inEdges.erase(*inEdge);
-          taskBag = curBag;
-          curBag->HB.insert(*inEdge);
-          break;  // could optimize by looking all bags
-        }
-      }
-
-      if (!taskBag) {
-        taskBag = new SerialBag(); // no bag inherited
-      }
-      // the number of inheriting bags
-      taskBag->outBufferCount = graph[taskID].outEdges.size();
+  }
 
-      // 2. merge the HBs of the parent nodes
-      inEdge = graph[taskID].inEdges.begin();
-      for (; inEdge != graph[taskID].inEdges.end(); inEdge++) {
+  hbEngine->beginTask(taskID, parents, outDegree);
+  peakLiveTasks = std::max(peakLiveTasks, hbEngine->liveTasks());
 
-        auto aBag = serial_bags[*inEdge];
+  graph.setName(taskID, names.intern(taskName)); // save the name
+}
 
-        taskBag->HB.insert(aBag->HB.begin(), aBag->HB.end()); // merging...
-        taskBag->HB.insert(*inEdge); // parents happen-before me
+// Checks the accesses still queued and collects their conflicts
+VOID Checker::finishChecking() {
+  beginOpenTask();
+  flushPendingActions();
+  mergeShardReports();
+}
 
-        aBag->outBufferCount--; // for inheriting bags
-        if (!aBag->outBufferCount) {
-          serial_bags.erase(*inEdge);
-        }
+BOOL Checker::coversRacyAddresses(const Checker &other) const {
+  for (const auto &otherShard : other.shards) {
+    for (const auto &entry : otherShard.racyAddresses) {
+      ADDRESS addr = reinterpret_cast<ADDRESS>(entry.first);
+      if ( !shards[ shardOf(addr) ].racyAddresses.find(entry.first) ) {
+        return false;
       }
-
-      graph[taskID].name  = taskName; // set the name of the task
-      serial_bags[taskID] = taskBag; // 3. add the bag to serial_bags
     }
   }
+  return true;
 }
 
 void Checker::checkCommutativeOperations(BugValidator &validator) {
-
-  // generate simplified version of conflicts from scratch
-  conflictTasksAndLines.clear();
-
-  // a pair of conflicting task body with a set of line numbers
-  for (auto it = conflictTable.begin(); it != conflictTable.end();
-      ++it) {
-    std::pair<std::string, std::string> namesPair =
-        std::make_pair(it->second.task1Name, it->second.task2Name);
-    if (conflictTasksAndLines.find(namesPair) ==
-        conflictTasksAndLines.end()) {
-      conflictTasksAndLines[namesPair] = std::set<std::pair<int,int>>();
-    }
-    // erase duplicates
-    for (auto conf = it->second.buggyAccesses.begin();
-         conf != it->second.buggyAccesses.end(); ) {
-      std::pair<int,int> lines =
-          std::make_pair(conf->action1.lineNo, conf->action2.lineNo);
-      auto inserted = conflictTasksAndLines[namesPair].insert(lines);
-      if (inserted.second == false) {
-        conf = it->second.buggyAccesses.erase( conf );
-      } else {
-        conf++;
-      } // end if
-    } // end for
+  finishChecking(); // if not done yet
+
+  // the instances of a pair of task bodies are reported once
+  // for each pair of lines, by the first pair of instances
+  FlatHashMap<std::unordered_set<uint64_t>> reportedLines; // by names
+  for (auto &entry : conflictTable) {
+    Report &report = entry.second;
+    std::unordered_set<uint64_t> &reported =
+        reportedLines[ packPair(report.task1Name, report.task2Name) ];
+    std::vector<uint64_t> firstLines; // of this pair of instances
+    report.buggyAccesses.eraseIf([&](const Conflict &conflict) {
+      uint64_t lines = packPair(conflict.action1.lineNo,
+                                conflict.action2.lineNo);
+      if ( reported.count(lines) ) return true;
+      firstLines.push_back(lines);
+      return false;
+    });
+    reported.insert(firstLines.begin(), firstLines.end());
   }
 
-  // a pair of conflicting task body with a set of line numbers
-  for (auto it = conflictTable.begin(); it != conflictTable.end(); ) {
-
-    Report & report = it->second;
-    validator.validate( report );
-
-    if ( !report.buggyAccesses.size() ) {
-       it = conflictTable.erase(it);
-    } else {
-      ++it;
-    } // end if
-  } // end for
+  // the reports are independent, validate them in parallel
+  auto reports = conflictTable.begin();
+  auto validate = [&](size_t index) {
+    validator.validate( reports[index].second );
+  };
+  if ( pool ) {
+    pool->run(conflictTable.size(), validate);
+  } else {
+    for (size_t i = 0; i < conflictTable.size(); i++) validate(i);
+  }
+  conflictTable.eraseIf([](const std::pair<uint64_t, Report> &entry) {
+    return entry.second.buggyAccesses.empty();
+  });
 }
 
 
@@ -322,6 +417,19 @@ VOID Checker::reportConflicts() {
   std::cout << "                    Summary                   " << std::endl;
   std::cout << "                                              " << std::endl;
   std::cout << " Total number of tasks: " <<  graph.size()      << std::endl;
+  if ( exactHistory ) {
+    std::cout << " Access history: exact" << std::endl;
+  } else {
+    size_t truncated = 0, dropped = 0;
+    for (auto &shard : shards) {
+      truncated += shard.writes.truncatedHistories();
+      dropped   += shard.writes.droppedRecords();
+    }
+    std::cout << " Access history: last " << historyDepth
+              << " accesses per address" << std::endl;
+    std::cout << " Truncated histories: " << truncated << " addresses, "
+              << dropped << " accesses dropped" << std::endl;
+  }
   std::cout << "                                              " << std::endl;
   std::cout << "                                              " << std::endl;
   std::cout << "                                              " << std::endl;
@@ -338,12 +446,23 @@ VOID Checker::reportConflicts() {
 
 #ifdef VERBOSE // print full summary
   for (auto it = conflictTable.begin(); it != conflictTable.end(); ++it) {
-    std::cout << "    "<< it->first.first << " ("
-              << it->second.task1Name<<")  <--> ";
-    std::cout << it->first.second << " ("
-              << it->second.task2Name << ")";
-    std::cout << " on "<< it->second.buggyAccesses.size()
-              << " memory addresses" << std::endl;
+    std::cout << "    "<< pairFirst(it->first) << " ("
+              << names.name(it->second.task1Name) <<")  <--> ";
+    std::cout << pairSecond(it->first) << " ("
+              << names.name(it->second.task2Name) << ")";
+    // the conflicts are ordered by address
+    size_t addresses = 0;
+    const Conflict *previous = NULL;
+    for (const auto &conflict : it->second.buggyAccesses) {
+      if (!previous || conflict.addr != previous->addr) addresses++;
+      previous = &conflict;
+    }
+    std::cout << " on "<< addresses << " memory addresses" << std::endl;
+    if ( it->second.capped() ) {
+      std::cout << "    " << it->second.conflicts
+                << " conflicts found, kept at most " << maxConflicts
+                << " and one per pair of lines" << std::endl;
+    }
 
     if (it->second.buggyAccesses.size() > 10) {
       std::cout << "    showing at most 10 addresses: " << std::endl;
@@ -372,8 +491,8 @@ VOID Checker::reportConflicts() {
   for (auto it = conflictTable.begin();
        it!= conflictTable.end(); it++) {
     Report &report = it->second;
-    std::cout << report.task1Name << " <--> "
-              << report.task2Name << ": line numbers  {";
+    std::cout << names.name(report.task1Name) << " <--> "
+              << names.name(report.task2Name) << ": line numbers  {";
 
     for (auto conflict = report.buggyAccesses.begin();
          conflict != report.buggyAccesses.end(); conflict++) {
@@ -398,11 +517,11 @@ VOID Checker::printHBGraph() {
     exit(-1);
   }
 
-  for (auto it = graph.begin(); it != graph.end(); it++) {
-    for (auto out = it->second.outEdges.begin();
-        out != it->second.outEdges.end(); out++) {
-       flowGraph << it->first << "_" << it->second.name << " pp ";
-       flowGraph << *out << "_" << graph[*out].name << std::endl;
+  for (size_t task = 0; task < graph.idBound(); task++) {
+    if ( !graph.contains(task) ) continue;
+    for (auto out : graph.children(task)) {
+       flowGraph << task << "_" << taskName(task) << " pp ";
+       flowGraph << out << "_" << taskName(out) << std::endl;
     }
   }
 
@@ -421,17 +540,20 @@ VOID Checker::printHBGraphJS() {
 
   // generate std::list of nodes
   graphJS << "nodes: [ \n";
-  for (auto it = graph.begin(); it != graph.end(); it++) {
-    if (it == graph.begin()) {
+  BOOL first = true;
+  for (size_t task = 0; task < graph.idBound(); task++) {
+    if ( !graph.contains(task) ) continue;
+    if ( first ) {
       graphJS << "      { data: { id: '"
-              << it->second.name << it->first
-              << "', name: '" << it->second.name
-              << it->first << "' }}";
+              << taskName(task) << task
+              << "', name: '" << taskName(task)
+              << task << "' }}";
+      first = false;
     } else {
       graphJS << ",\n      { data: { id: '"
-              << it->second.name << it->first
-              << "', name: '" << it->second.name
-              << it->first << "' }}";
+              << taskName(task) << task
+              << "', name: '" << taskName(task)
+              << task << "' }}";
     }
   }
   graphJS << "\n     ],\n";
@@ -439,25 +561,23 @@ VOID Checker::printHBGraphJS() {
   // generate std::list of edges
   graphJS << "edges: [ \n";
   int start = 1;
-  for (auto it = graph.begin(); it != graph.end(); it++) {
-    for (auto out = it->second.outEdges.begin();
-        out != it->second.outEdges.end(); out++) {
+  for (size_t task = 0; task < graph.idBound(); task++) {
+    if ( !graph.contains(task) ) continue;
+    for (auto out : graph.children(task)) {
       if (start) {
-        graphJS << "      { data: { source: '" << it->second.name
-                << it->first << "', target: '" << graph[*out].name
-                << *out << "' }}";
+        graphJS << "      { data: { source: '" << taskName(task)
+                << task << "', target: '" << taskName(out)
+                << out << "' }}";
         start = 0;
       } else {
-        graphJS << ",\n      { data: { source: '" << it->second.name
-                << it->first << "', target: '" << graph[*out].name
-                << *out << "' }}";
+        graphJS << ",\n      { data: { source: '" << taskName(task)
+                << task << "', target: '" << taskName(out)
+                << out << "' }}";
       }
     }
   }
   graphJS << "\n     ]\n";
 
-   //    graphJS << it->first << "_" << it->second.name << " pp ";
-   //    graphJS << *out << "_" << graph[*out].name << std::endl;
   if (graphJS.is_open()) {
     graphJS.close();
   }
@@ -465,30 +585,49 @@ VOID Checker::printHBGraphJS() {
 
 
 VOID Checker::testing() {
-  for (auto it = writes.begin(); it != writes.end(); it++) {
-     std::cout << it->first << ": Bucket {" << it->second.size();
-     std::cout <<"} "<< std::endl;
+  flushPendingActions();
+
+  size_t totalAddresses = 0;
+  size_t shadowBytes    = 0;
+  for (auto &shard : shards) {
+    shard.writes.forEach([](ADDRESS addr, size_t records) {
+       std::cout << addr << ": Bucket {" << records;
+       std::cout <<"} "<< std::endl;
+    });
+    totalAddresses += shard.writes.addresses();
+    shadowBytes    += shard.writes.memoryUsed();
   }
-  std::cout << "Total Addresses: " << writes.size() << std::endl;
+  std::cout << "Total Addresses: " << totalAddresses << std::endl;
+  std::cout << "Shadow memory: " << shadowBytes << " bytes" << std::endl;
 
   // testing
   std::cout << "====================" << std::endl;
-  for (auto it = serial_bags.begin(); it != serial_bags.end(); it++) {
-      std::cout << it->first << " ("
-                << it->second->outBufferCount<< "): {";
-      for (auto x = it->second->HB.begin();
-          x != it->second->HB.end(); x++ ) {
-        std::cout << *x << " ";
-      }
-      std::cout << "}" << std::endl;
-  }
+  hbEngine->print();
 }
 
+// Adds the state of the checker to the profile
+VOID Checker::addCounters(Profiler &profiler) const {
+  size_t addresses = 0, shadowBytes = 0, truncated = 0, dropped = 0;
+  for (const auto &shard : shards) {
+    addresses   += shard.writes.addresses();
+    shadowBytes += shard.writes.memoryUsed();
+    truncated   += shard.writes.truncatedHistories();
+    dropped     += shard.writes.droppedRecords();
+  }
 
-// implementation of the checker destructor
-// frees the memory dynamically generated for S-bags
-Checker::~Checker() {
- for (auto it = serial_bags.begin(); it != serial_bags.end(); it++) {
-   delete it->second;
- }
+  size_t merges = hbEngine->mergeCount();
+  profiler.setCounter("events", events);
+  profiler.setCounter("accesses", accesses);
+  profiler.setCounter("tasks", graph.size());
+  profiler.setCounter("addresses", addresses);
+  profiler.setCounter("shadow_memory_bytes", shadowBytes);
+  profiler.setCounter("truncated_histories", truncated);
+  profiler.setCounter("dropped_accesses", dropped);
+  profiler.setCounter("hb_live_tasks", hbEngine->liveTasks());
+  profiler.setCounter("hb_peak_live_tasks", peakLiveTasks);
+  profiler.setCounter("hb_merges", merges);
+  profiler.setCounter("hb_mean_merge_size",
+      merges ? static_cast<double>(hbEngine->mergedTasks()) / merges : 0);
+  profiler.setCounter("conflicts_found", conflictsFound);
+  profiler.setCounter("task_pairs_reported", conflictTable.size());
 }
@@ -24,57 +24,178 @@
 #include "sigManager.hpp"     // for managing function names
 #include "MemoryActions.hpp"
 #include "validator.hpp"
-#include <list>
+#include "threadPool.hpp"
+#include "hbEngine.hpp"
+#include "options.hpp"
+#include "shadowMemory.hpp"
+#include "taskGraph.hpp"
+#include "nameInterner.hpp"
+#include "flatHash.hpp"
+#include "profiler.hpp"
+#include <memory>
 
-// a bag to hold the tasks that happened-before
-typedef struct SerialBag {
-  int             outBufferCount;
-  UNORD_INTSET    HB;
+// an access queued for checking
+typedef struct PendingAccess {
+  ADDRESS       addr;
+  AccessRecord  access;
+} PendingAccess;
 
-  SerialBag(): outBufferCount(0){}
-} SerialBag;
+// The conflict detection state of a subset of the addresses.
+// Each shard is checked by one thread at a time.
+typedef struct CheckerShard {
+  ShadowMemory                                 writes;
+  std::vector<AccessSummary>                   summaries; // if exact
+  FlatHashMap<Report>                          conflictTable; // task pairs
+  FlatHashMap<BOOL>                            racyAddresses; // found racy
+  std::vector<PendingAccess>                   pending; // not checked yet
 
-// for constructing happans-before between tasks
-typedef struct Task {
-  std::string     name;       // name of the task
-  UNORD_INTSET    inEdges;    // incoming data streams
-  UNORD_INTSET    outEdges;   // outgoing data streams
-} Task;
-
-typedef SerialBag *SerialBagPtr;
+  explicit CheckerShard(size_t historyDepth): writes(historyDepth) {}
+} CheckerShard;
 
 class Checker {
   public:
-  VOID addTaskNode(std::string &logLine);
+  // task and function names are interned in "names"
+  Checker(const CheckerOptions &options, NameInterner &names);
+
   VOID saveTaskActions(const MemoryActions &taskActions);
-  VOID processLogLines(std::string &line);
+
+  // typed events, used by the log readers
+  VOID addTaskEdge(INTEGER sibId, INTEGER parId);
+  VOID beginTask(INTEGER taskID, const std::string &taskName);
+  VOID registerFunction(INTEGER funcID, const std::string &funcName);
+
+  // events used online, where the edges of a task come with its
+  // token receive events instead of an HBlog
+  VOID receiveToken(INTEGER taskID, INTEGER parentID);
+
+  // the running task ended: its accesses are all in the trace
+  VOID endTask();
+
+  // checks the accesses still queued once the trace is read
+  VOID finishChecking();
 
   // a pair of conflicting task body with a set of line numbers
   VOID checkCommutativeOperations( BugValidator &validator );
 
+  // true if this checker found a race on every address on which
+  // "other" found one, once both finished checking
+  BOOL coversRacyAddresses(const Checker &other) const;
+
+  // the number of trace events received so far
+  inline uint64_t eventCount() const { return events; }
+
+  // the seconds spent checking accesses so far; a single thread
+  // estimates them from a sample of its checks, with --profile only
+  inline double checkSeconds() const { return checkNanos / 1e9; }
+
+  // adds the counters of the checker to "profiler" (--profile)
+  VOID addCounters(Profiler &profiler) const;
+
+  // true at the end of a task once a snapshot is due (--checkpoint)
+  inline BOOL checkpointDue() const { return checkpointReady; }
+
+  // saves a snapshot, the trace (from "trace") continues at "offset"
+  VOID saveCheckpoint(const char *trace, size_t offset);
+
+  // loads the snapshot "fileName" before the logs are read
+  BOOL resume(const char *fileName);
+
+  // the offset in "trace" where reading resumes, 0 if not resumed;
+  // false if the snapshot was not taken on this trace
+  BOOL resumeOffset(const char *trace, size_t size, size_t &offset) const;
+
   VOID reportConflicts();
   VOID printHBGraph();
   VOID printHBGraphJS();  // for printing dependency graph in JS format
   VOID testing();
-  ~Checker();
 
   private:
-    /** Constructs action object from the log file */
-    VOID constructMemoryAction(std::stringstream &ssin,
-                               std::string &opType,
-                               Action &action);
-
-    VOID saveNondeterminismReport(const Action &curWrite,
-                                  const Action &write);
-
-    // hold bags of tasks
-    std::unordered_map <INTEGER, SerialBagPtr>   serial_bags;
-    std::unordered_map<INTEGER, Task>            graph; // in&out edges
-    //// for writes
-    std::unordered_map<ADDRESS,
-        std::list<MemoryActions>>                writes;
-    std::map<std::pair<STRING, STRING>, Report>  conflictTable;
-    CONFLICT_PAIRS                               conflictTasksAndLines;
+    VOID checkAccess(CheckerShard &shard, ADDRESS addr,
+                     const AccessRecord &access);
+
+    // checks against the access summary of the address, if exact
+    VOID checkAccessExact(CheckerShard &shard, ADDRESS addr,
+                          const AccessRecord &access);
+
+    // returns true if the accesses of different tasks conflict
+    inline BOOL conflicting(const AccessRecord &access,
+                            const AccessRecord &prev) const {
+      return access.taskId != prev.taskId &&
+             (access.isWrite || prev.isWrite) &&
+             !(access.isWrite && prev.isWrite &&
+               access.value == prev.value) &&
+             !hbEngine->happensBefore(prev.taskId, access.taskId);
+    }
+
+    // true if "prev" is of the task of "access" or happens-before it
+    inline BOOL ordered(const AccessRecord &prev,
+                        const AccessRecord &access) const {
+      return prev.taskId == access.taskId ||
+             hbEngine->happensBefore(prev.taskId, access.taskId);
+    }
+
+    VOID saveNondeterminismReport(CheckerShard &shard, ADDRESS addr,
+                                  const AccessRecord &curWrite,
+                                  const AccessRecord &write);
+
+    // checks the actions queued in the shards
+    VOID flushPendingActions();
+
+    // registers a task which begins in the happens-before engine
+    VOID startTask(INTEGER taskID, const std::string &taskName,
+                   const INTVECTOR &parents, INTEGER outDegree);
+
+    // online, begins the task whose parents are collected
+    VOID beginOpenTask();
+
+    // moves the conflicts found by the shards to conflictTable
+    VOID mergeShardReports();
+
+    inline size_t shardOf(ADDRESS addr) const {
+      uint64_t key = reinterpret_cast<uint64_t>(addr);
+      return ((key * 0x9E3779B97F4A7C15ULL) >> 32) % shards.size();
+    }
+
+    // writes and reads the state saved in snapshots
+    VOID saveState(SnapshotWriter &out);
+    BOOL loadState(SnapshotReader &in);
+
+    // returns the name of a task, safe to call from any shard
+    inline const std::string &taskName(INTEGER taskId) const {
+      return names.name( graph.name(taskId) );
+    }
+
+    // answers happens-before queries between tasks
+    std::unique_ptr<HBEngine>                    hbEngine;
+    BOOL                                         exactHistory;
+    unsigned                                     historyDepth;
+    unsigned                                     maxConflicts; // per pair
+    BOOL                                         online; // streaming
+    INTEGER                                      openTask; // -1 if none
+    std::string                                  openTaskName;
+    INTVECTOR                                    openParents;
+    TaskGraph                                    graph; // in&out edges
+    //// for writes, partitioned by address
+    std::vector<CheckerShard>                    shards;
+    std::unique_ptr<ThreadPool>                  pool; // if threads > 1
+    UNORD_INTSET                                 pendingTasks;
+    size_t                                       pendingCount;
+    FlatHashMap<Report>                          conflictTable; // task pairs
+    uint64_t                                     events; // of the trace
+    uint64_t                                     accesses;
+    size_t                                       peakLiveTasks; // HB
+    uint64_t                                     conflictsFound;
+    BOOL                                         profiled; // --profile
+    uint64_t                                     checkNanos; // checking
+    std::string                                  engineKind; // --hb
+    // snapshots
+    std::string                                  checkpointName;
+    uint64_t                                     checkpointEvery; // events
+    uint64_t                                     nextCheckpoint;
+    BOOL                                         checkpointReady;
+    BOOL                                         resumed;
+    Checkpoint::FileHeader                       resumeHeader;
+    NameInterner                                &names;
     // For holding function signatures.
     SigManager                                   signatureManager;
 };
@@ -0,0 +1,260 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements the snapshots of the checker state (--checkpoint)
+// and resuming from them (--resume).
+
+#include "checker.hpp"
+#include "mappedFile.hpp"
+#include <cstdio>
+
+// the fields of an action kept in a conflict
+static VOID saveAction(SnapshotWriter &out, const Action &action) {
+  out.write<int64_t>(action.taskId);
+  out.write<int64_t>(action.value);
+  out.write<int64_t>(action.lineNo);
+  out.write<int64_t>(action.funcId);
+  out.write<uint8_t>(action.isWrite);
+}
+
+static VOID loadAction(SnapshotReader &in, ADDRESS addr, Action &action) {
+  action.addr    = addr;
+  action.taskId  = in.read<int64_t>();
+  action.value   = in.read<int64_t>();
+  action.lineNo  = in.read<int64_t>();
+  action.funcId  = in.read<int64_t>();
+  action.isWrite = in.read<uint8_t>() != 0;
+}
+
+// Saves the state at the end of a task, once every access read
+// is checked. The snapshot replaces the previous one only once
+// it is complete.
+VOID Checker::saveCheckpoint(const char *trace, size_t offset) {
+  checkpointReady = false;
+  nextCheckpoint  = events + checkpointEvery;
+  flushPendingActions();
+
+  std::string temporary = checkpointName + ".tmp";
+  FILE *file = fopen(temporary.c_str(), "wb");
+  if ( !file ) {
+    std::cout << "Warning: checkpoint " << temporary
+              << " could not be written." << std::endl;
+    return;
+  }
+
+  Checkpoint::FileHeader header;
+  header.traceOffset = offset;
+  header.traceHash   = Checkpoint::traceHash(trace, offset);
+
+  SnapshotWriter out(file);
+  out.write(header);
+  saveState(out);
+  BOOL written = out.good();
+  written = (fclose(file) == 0) && written;
+
+  if (!written ||
+      rename(temporary.c_str(), checkpointName.c_str()) != 0) {
+    std::cout << "Warning: checkpoint " << checkpointName
+              << " could not be written." << std::endl;
+    remove(temporary.c_str());
+    return;
+  }
+  std::cout << "Checkpoint: " << events << " events, trace offset "
+            << offset << std::endl;
+}
+
+BOOL Checker::resume(const char *fileName) {
+  MappedFile snapshot;
+  if ( !snapshot.open(fileName) ) {
+    std::cout << "Snapshot: " << fileName << " could not be read."
+              << std::endl;
+    return false;
+  }
+
+  SnapshotReader in(snapshot.begin(), snapshot.end());
+  resumeHeader = in.read<Checkpoint::FileHeader>();
+  if (!in.good() || !Checkpoint::isValidHeader(resumeHeader)) {
+    std::cout << "Snapshot: " << fileName << " is not a snapshot of "
+              << "this version." << std::endl;
+    return false;
+  }
+  if ( !loadState(in) ) {
+    std::cout << "Snapshot: " << fileName << " is corrupt or was taken "
+              << "with other options." << std::endl;
+    return false;
+  }
+
+  resumed = true;
+  nextCheckpoint = events + checkpointEvery;
+  return true;
+}
+
+BOOL Checker::resumeOffset(const char *trace, size_t size,
+                           size_t &offset) const {
+  offset = 0;
+  if ( !resumed ) return true;
+
+  offset = resumeHeader.traceOffset;
+  if (offset > size ||
+      Checkpoint::traceHash(trace, offset) != resumeHeader.traceHash) {
+    std::cout << "Snapshot: the trace differs from the trace it was "
+              << "taken on." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// The options which shape the state, then the state itself
+VOID Checker::saveState(SnapshotWriter &out) {
+  out.writeString(engineKind);
+  out.write<uint8_t>(exactHistory);
+  out.write<uint32_t>(historyDepth);
+  out.write<uint32_t>(maxConflicts);
+
+  out.write<uint64_t>(events);
+  out.write<uint64_t>(accesses);
+  out.write<uint64_t>(peakLiveTasks);
+  out.write<uint64_t>(conflictsFound);
+
+  names.save(out);
+  signatureManager.save(out);
+  graph.save(out);
+  hbEngine->save(out);
+
+  // the histories of the addresses, independent of the shards
+  uint64_t addresses = 0, dropped = 0;
+  for (auto &shard : shards) {
+    addresses += shard.writes.addresses();
+    dropped   += shard.writes.droppedRecords();
+  }
+  out.write<uint64_t>(addresses);
+  out.write<uint64_t>(dropped);
+
+  std::vector<AccessRecord> records;
+  for (auto &shard : shards) {
+    if ( exactHistory ) {
+      shard.writes.forEach([&](ADDRESS addr, size_t) {
+        const AccessSummary &summary =
+            shard.summaries[ shard.writes.addressIndex(addr) ];
+        out.write<uint64_t>( reinterpret_cast<uint64_t>(addr) );
+        out.writeVector(summary.writes);
+        out.writeVector(summary.reads);
+      });
+      continue;
+    }
+
+    shard.writes.forEachHistory([&](ADDRESS addr,
+                                    ShadowMemory::History history,
+                                    BOOL truncated) {
+      records.clear();
+      for (size_t i = 0; i < history.size(); i++) {
+        records.push_back( history[i] );
+      }
+      out.write<uint64_t>( reinterpret_cast<uint64_t>(addr) );
+      out.write<uint8_t>(truncated);
+      out.writeVector(records);
+    });
+  }
+
+  // the conflicts found by each shard, not merged yet
+  out.write<uint64_t>(shards.size());
+  for (auto &shard : shards) {
+    out.write<uint64_t>(shard.conflictTable.size());
+    for (auto &entry : shard.conflictTable) {
+      const Report &report = entry.second;
+      out.write<uint64_t>(entry.first);
+      out.write<int64_t>(report.task1Name);
+      out.write<int64_t>(report.task2Name);
+      out.write<uint64_t>(report.conflicts);
+      out.write<uint64_t>(report.buggyAccesses.size());
+      for (const auto &conflict : report.buggyAccesses) {
+        out.write<uint64_t>( reinterpret_cast<uint64_t>(conflict.addr) );
+        saveAction(out, conflict.action1);
+        saveAction(out, conflict.action2);
+      }
+    }
+  }
+}
+
+// Loads a state saved with the same options, with any number of
+// threads: the addresses are sharded again
+BOOL Checker::loadState(SnapshotReader &in) {
+  std::string kind;
+  in.readString(kind);
+  BOOL     exact = in.read<uint8_t>() != 0;
+  unsigned depth = in.read<uint32_t>();
+  unsigned cap   = in.read<uint32_t>();
+  if (!in.good() || kind != engineKind || exact != exactHistory ||
+      depth != historyDepth || cap != maxConflicts || names.size()) {
+    return false;
+  }
+
+  events         = in.read<uint64_t>();
+  accesses       = in.read<uint64_t>();
+  peakLiveTasks  = in.read<uint64_t>();
+  conflictsFound = in.read<uint64_t>();
+
+  if (!names.load(in) || !signatureManager.load(in) ||
+      !graph.load(in) || !hbEngine->load(in)) {
+    return false;
+  }
+
+  uint64_t addresses = in.read<uint64_t>();
+  shards[0].writes.restoreDropped( in.read<uint64_t>() );
+
+  std::vector<AccessRecord> records;
+  for (uint64_t i = 0; i < addresses && in.good(); i++) {
+    ADDRESS addr = reinterpret_cast<ADDRESS>( in.read<uint64_t>() );
+    CheckerShard &shard = shards[ shardOf(addr) ];
+
+    if ( exactHistory ) {
+      size_t index = shard.writes.addressIndex(addr);
+      if (index >= shard.summaries.size()) {
+        shard.summaries.resize(index + 1);
+      }
+      in.readVector(shard.summaries[index].writes);
+      in.readVector(shard.summaries[index].reads);
+      continue;
+    }
+
+    BOOL truncated = in.read<uint8_t>() != 0;
+    in.readVector(records);
+    if (records.size() > historyDepth) return false;
+    shard.writes.restore(addr, records, truncated);
+  }
+
+  // the reports of a shard saved go to a shard, merged
+  uint64_t savedShards = in.read<uint64_t>();
+  for (uint64_t s = 0; s < savedShards && in.good(); s++) {
+    FlatHashMap<Report> &table = shards[s % shards.size()].conflictTable;
+    uint64_t reports = in.read<uint64_t>();
+
+    for (uint64_t r = 0; r < reports && in.good(); r++) {
+      Report &report = table[ in.read<uint64_t>() ];
+      report.task1Name  = in.read<int64_t>();
+      report.task2Name  = in.read<int64_t>();
+      report.conflicts += in.read<uint64_t>();
+
+      uint64_t conflicts = in.read<uint64_t>();
+      for (uint64_t c = 0; c < conflicts && in.good(); c++) {
+        ADDRESS addr = reinterpret_cast<ADDRESS>( in.read<uint64_t>() );
+        Action action1, action2;
+        loadAction(in, addr, action1);
+        loadAction(in, addr, action2);
+        if ( report.keeps(action1.lineNo, action2.lineNo, maxConflicts) ) {
+          report.buggyAccesses.insert( Conflict(action1, action2) );
+        }
+      }
+    }
+  }
+  return in.good();
+}
@@ -0,0 +1,156 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the snapshot file of the checker state (--checkpoint).
+// A snapshot is taken at the end of a task, where every access
+// read so far is checked. It starts with a FileHeader giving the
+// offset of the next event in the Tracelog and the hash of the
+// bytes before it, followed by sections written in order by the
+// parts of the checker: the names, the task graph, the HB engine,
+// the access histories and the conflicts. Each part writes its
+// own state with a SnapshotWriter and reads it back with a
+// SnapshotReader.
+
+#ifndef _DETECTOR_CHECKPOINT_HPP_
+#define _DETECTOR_CHECKPOINT_HPP_
+
+#include "defs.hpp"
+#include "irCache.hpp" // for hashing the trace
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// the bytes of the Tracelog hashed before the resume offset
+#define CHECKPOINT_TRACE_WINDOW 4096
+
+namespace Checkpoint {
+
+  const char      MAGIC[8]  = { 'D', 'F', 'C', 'H', 'E', 'C', 'K', 'P' };
+  const uint32_t  VERSION   = 2;
+  const uint32_t  BYTEORDER = 0x01020304;
+
+  typedef struct FileHeader {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  byteOrder;
+    uint64_t  traceOffset; // of the next event
+    uint64_t  traceHash;   // of the window before it
+
+    FileHeader(): magic(), version(VERSION), byteOrder(BYTEORDER),
+                  traceOffset(0), traceHash(0) {
+      memcpy(magic, MAGIC, sizeof(magic));
+    }
+  } FileHeader;
+
+  inline bool isValidHeader(const FileHeader &header) {
+    return memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+           header.version   == VERSION &&
+           header.byteOrder == BYTEORDER;
+  }
+
+  /** Hashes the bytes of the trace before "offset" */
+  inline uint64_t traceHash(const char *trace, size_t offset) {
+    size_t window = std::min<size_t>(offset, CHECKPOINT_TRACE_WINDOW);
+    return IRCache::hash(trace + offset - window, window);
+  }
+
+} // end namespace
+
+// Writes the values of a snapshot to a file, buffered by stdio
+class SnapshotWriter {
+  public:
+    explicit SnapshotWriter(FILE *file_): file(file_), failed(false) {}
+
+    /** Writes a value of a trivially copyable type */
+    template <typename T>
+    inline VOID write(const T &value) {
+      writeBytes(&value, sizeof(T));
+    }
+
+    /** Writes the size and the elements of a vector */
+    template <typename T>
+    VOID writeVector(const std::vector<T> &values) {
+      write<uint64_t>(values.size());
+      writeBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    VOID writeString(const std::string &text) {
+      write<uint64_t>(text.size());
+      writeBytes(text.data(), text.size());
+    }
+
+    inline BOOL good() const { return !failed; }
+
+  private:
+    inline VOID writeBytes(const void *data, size_t size) {
+      if (size && fwrite(data, 1, size, file) != size) failed = true;
+    }
+
+    FILE  *file;
+    BOOL   failed;
+};
+
+// Reads the values of a snapshot from its mapping. Reading past
+// the end fails the reader and returns zeros.
+class SnapshotReader {
+  public:
+    SnapshotReader(const char *begin, const char *end)
+        : pos(begin), last(end), failed(false) {}
+
+    template <typename T>
+    inline T read() {
+      T value = T();
+      readBytes(&value, sizeof(T));
+      return value;
+    }
+
+    template <typename T>
+    VOID readVector(std::vector<T> &values) {
+      uint64_t size = read<uint64_t>();
+      if (failed || size > static_cast<uint64_t>(last - pos) / sizeof(T)) {
+        failed = true;
+        values.clear();
+        return;
+      }
+      values.resize(size);
+      readBytes(values.data(), size * sizeof(T));
+    }
+
+    VOID readString(std::string &text) {
+      uint64_t size = read<uint64_t>();
+      if (failed || size > static_cast<uint64_t>(last - pos)) {
+        failed = true;
+        text.clear();
+        return;
+      }
+      text.assign(pos, size);
+      pos += size;
+    }
+
+    inline BOOL good() const { return !failed; }
+
+  private:
+    inline VOID readBytes(void *data, size_t size) {
+      if (failed || size > static_cast<size_t>(last - pos)) {
+        failed = true;
+        return;
+      }
+      memcpy(data, pos, size);
+      pos += size;
+    }
+
+    const char  *pos;
+    const char  *last;
+    BOOL         failed;
+};
+
+#endif // end checkpoint.hpp
@@ -16,6 +16,9 @@
 // includes and definitions
 #include "defs.hpp"
 #include "action.hpp" // defines Action class
+#include "flatHash.hpp"
+#include <cstdint>
+#include <memory>
 
 // This struct keeps the line information of the
 // address with determinism conflict
@@ -31,9 +34,42 @@ class Conflict {
     addr    = curMemAction.addr;
   }
 
+  // a conflict is identified by its address, its pair of lines
+  // and its pair of functions, the tasks are those of the Report
+  bool operator==(const Conflict &RHS) const {
+    return addr           == RHS.addr           &&
+           action1.lineNo == RHS.action1.lineNo &&
+           action2.lineNo == RHS.action2.lineNo &&
+           action1.funcId == RHS.action1.funcId &&
+           action2.funcId == RHS.action2.funcId;
+  }
+
   bool operator<(const Conflict &RHS) const {
-    return addr < RHS.addr || action1.taskId < action2.taskId;
+    if (addr != RHS.addr) return addr < RHS.addr;
+    if (action1.lineNo != RHS.action1.lineNo) {
+      return action1.lineNo < RHS.action1.lineNo;
+    }
+    if (action2.lineNo != RHS.action2.lineNo) {
+      return action2.lineNo < RHS.action2.lineNo;
+    }
+    if (action1.funcId != RHS.action1.funcId) {
+      return action1.funcId < RHS.action1.funcId;
+    }
+    return action2.funcId < RHS.action2.funcId;
   }
+
+  // hashes the identity of a conflict
+  struct Hash {
+    uint64_t operator()(const Conflict &conflict) const {
+      uint64_t lines = packPair(conflict.action1.lineNo,
+                                conflict.action2.lineNo);
+      uint64_t funcs = packPair(conflict.action1.funcId,
+                                conflict.action2.funcId);
+      uint64_t addr  = reinterpret_cast<uintptr_t>(conflict.addr);
+      return (addr * 0xFF51AFD7ED558CCDULL) ^
+             (lines * 0xC4CEB9FE1A85EC53ULL) ^ funcs;
+    }
+  };
 }; // end Conflict
 
 
@@ -41,9 +77,35 @@ class Conflict {
 // and the addresses they conflict at
 class Report {
  public:
-  std::string         task1Name;
-  std::string         task2Name;
-  std::set<Conflict>  buggyAccesses;
+  INTEGER             task1Name;  // interned names
+  INTEGER             task2Name;
+  FlatHashSet<Conflict, Conflict::Hash>  buggyAccesses; // distinct
+  uint64_t            conflicts;  // all found, also those not kept
+
+  // the pairs of lines of the accesses, once the cap is reached
+  std::unique_ptr<std::unordered_set<uint64_t>>  cappedLines;
+
+  Report(): task1Name(-1), task2Name(-1), conflicts(0) {}
+
+  inline BOOL capped() const { return cappedLines != nullptr; }
+
+  /**
+   * Checks whether a conflict between lines "line1" and "line2"
+   * is to be kept. Once "cap" conflicts are kept (if not 0), only
+   * those on new pairs of lines are, as the validator checks the
+   * pairs of lines.
+   */
+  BOOL keeps(INTEGER line1, INTEGER line2, size_t cap) {
+    if (!cap || buggyAccesses.size() < cap) return true;
+    if ( !cappedLines ) {
+      cappedLines.reset( new std::unordered_set<uint64_t>() );
+      for (const auto &conflict : buggyAccesses) {
+        cappedLines->insert( packPair(conflict.action1.lineNo,
+                                      conflict.action2.lineNo) );
+      }
+    }
+    return cappedLines->insert( packPair(line1, line2) ).second;
+  }
 }; // end Report
 
 #endif // end conflictReport.h
@@ -0,0 +1,225 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines a flat hash map keyed by 64-bit integers, such as a
+// pair of ids packed with packPair(), and a flat hash set. The
+// entries are stored contiguously in insertion order and found
+// through an open addressing table of entry indexes with linear
+// probing.
+
+#ifndef _DETECTOR_FLATHASH_HPP_
+#define _DETECTOR_FLATHASH_HPP_
+
+#include "defs.hpp"
+#include <cstdint>
+
+// packs a pair of non-negative ids in a key
+inline uint64_t packPair(INTEGER first, INTEGER second) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32) |
+         static_cast<uint32_t>(second);
+}
+
+inline INTEGER pairFirst(uint64_t key) {
+  return static_cast<INTEGER>(key >> 32);
+}
+
+inline INTEGER pairSecond(uint64_t key) {
+  return static_cast<INTEGER>(static_cast<uint32_t>(key));
+}
+
+template <typename ValueT>
+class FlatHashMap {
+  public:
+    typedef std::pair<uint64_t, ValueT>               Entry;
+    typedef typename std::vector<Entry>::iterator     iterator;
+    typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+    FlatHashMap(): mask(0) {}
+
+    inline iterator begin() { return entries.begin(); }
+    inline iterator end()   { return entries.end(); }
+    inline const_iterator begin() const { return entries.begin(); }
+    inline const_iterator end()   const { return entries.end(); }
+
+    inline size_t size()  const { return entries.size(); }
+    inline BOOL   empty() const { return entries.empty(); }
+
+    /** Returns the value of "key", or NULL if absent */
+    inline ValueT *find(uint64_t key) {
+      if ( entries.empty() ) return NULL;
+      uint32_t index = slots[slotOf(key)];
+      return index ? &entries[index - 1].second : NULL;
+    }
+
+    inline const ValueT *find(uint64_t key) const {
+      if ( entries.empty() ) return NULL;
+      uint32_t index = slots[slotOf(key)];
+      return index ? &entries[index - 1].second : NULL;
+    }
+
+    /**
+     * Returns the value of "key", adding a default one if absent.
+     * The reference is valid until the next insertion.
+     */
+    inline ValueT &operator[](uint64_t key) {
+      if ((entries.size() + 1) * 2 > slots.size()) grow();
+
+      uint32_t &index = slots[slotOf(key)];
+      if ( !index ) {
+        entries.push_back( Entry(key, ValueT()) );
+        index = entries.size();
+      }
+      return entries[index - 1].second;
+    }
+
+    VOID clear() {
+      entries.clear();
+      std::fill(slots.begin(), slots.end(), 0);
+    }
+
+    /** Removes the entries for which pred(entry) is true */
+    template <typename PredT>
+    VOID eraseIf(PredT pred) {
+      size_t kept = 0;
+      for (size_t i = 0; i < entries.size(); i++) {
+        if ( pred(entries[i]) ) continue;
+        if (kept != i) entries[kept] = std::move(entries[i]);
+        kept++;
+      }
+      entries.erase(entries.begin() + kept, entries.end());
+      reindex();
+    }
+
+    /** Orders the entries by key, for deterministic iteration */
+    VOID sortByKey() {
+      std::sort(entries.begin(), entries.end(),
+                [](const Entry &a, const Entry &b) {
+                  return a.first < b.first;
+                });
+      reindex();
+    }
+
+  private:
+    // the slot of "key", or the empty slot where it belongs
+    inline size_t slotOf(uint64_t key) const {
+      size_t slot = (key * 0x9E3779B97F4A7C15ULL) >> 32 & mask;
+      while (slots[slot] && entries[slots[slot] - 1].first != key) {
+        slot = (slot + 1) & mask;
+      }
+      return slot;
+    }
+
+    VOID grow() {
+      slots.assign(std::max<size_t>(16, slots.size() * 2), 0);
+      mask = slots.size() - 1;
+      reindex();
+    }
+
+    VOID reindex() {
+      std::fill(slots.begin(), slots.end(), 0);
+      for (size_t i = 0; i < entries.size(); i++) {
+        slots[slotOf(entries[i].first)] = i + 1;
+      }
+    }
+
+    std::vector<Entry>     entries;
+    std::vector<uint32_t>  slots; // entry index + 1, 0 if empty
+    size_t                 mask;
+};
+
+// the size up to which a set has no table of indexes
+#define FLAT_SET_LINEAR 6
+
+// A set of values hashed with HashT and compared with ==
+template <typename ValueT, typename HashT>
+class FlatHashSet {
+  public:
+    typedef typename std::vector<ValueT>::const_iterator  const_iterator;
+
+    FlatHashSet(): mask(0) {}
+
+    inline const_iterator begin() const { return values.begin(); }
+    inline const_iterator end()   const { return values.end(); }
+
+    inline size_t size()  const { return values.size(); }
+    inline BOOL   empty() const { return values.empty(); }
+
+    /** Adds "value", returns false if it was present */
+    inline BOOL insert(const ValueT &value) {
+      if ( slots.empty() ) { // a small set is searched linearly
+        if (std::find(values.begin(), values.end(), value) !=
+            values.end()) {
+          return false;
+        }
+        if (values.size() < FLAT_SET_LINEAR) {
+          values.push_back(value);
+          return true;
+        }
+      }
+      if ((values.size() + 1) * 2 > slots.size()) grow();
+
+      uint32_t &index = slots[slotOf(value)];
+      if ( index ) return false;
+      values.push_back(value);
+      index = values.size();
+      return true;
+    }
+
+    VOID clear() {
+      values.clear();
+      slots.clear();
+    }
+
+    /** Removes the values for which pred(value) is true */
+    template <typename PredT>
+    VOID eraseIf(PredT pred) {
+      values.erase(std::remove_if(values.begin(), values.end(), pred),
+                   values.end());
+      reindex();
+    }
+
+    /** Orders the values with <, for deterministic iteration */
+    VOID sort() {
+      std::sort(values.begin(), values.end());
+      reindex();
+    }
+
+  private:
+    // the slot of "value", or the empty slot where it belongs
+    inline size_t slotOf(const ValueT &value) const {
+      size_t slot = (HashT()(value) * 0x9E3779B97F4A7C15ULL) >> 32 & mask;
+      while (slots[slot] && !(values[slots[slot] - 1] == value)) {
+        slot = (slot + 1) & mask;
+      }
+      return slot;
+    }
+
+    VOID grow() {
+      slots.assign(std::max<size_t>(16, slots.size() * 2), 0);
+      mask = slots.size() - 1;
+      reindex();
+    }
+
+    VOID reindex() {
+      if ( slots.empty() ) return; // small
+      std::fill(slots.begin(), slots.end(), 0);
+      for (size_t i = 0; i < values.size(); i++) {
+        slots[slotOf(values[i])] = i + 1;
+      }
+    }
+
+    std::vector<ValueT>    values;
+    std::vector<uint32_t>  slots; // value index + 1, 0 if empty
+    size_t                 mask;
+};
+
+#endif // end flatHash.hpp
@@ -0,0 +1,296 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements the happens-before engines.
+
+#include "hbEngine.hpp"
+
+HBEngine *HBEngine::create(const std::string &kind) {
+  if (kind == "bags")    return new SerialBagEngine<HashTaskSet>();
+  if (kind == "bitbags") return new SerialBagEngine<TaskSet>();
+  if (kind == "clocks")  return new ChainClockEngine();
+  return NULL;
+}
+
+
+// implementation of the bags destructor
+// frees the memory dynamically generated for S-bags
+template <typename SetT>
+SerialBagEngine<SetT>::~SerialBagEngine() {
+ for (auto it = serial_bags.begin(); it != serial_bags.end(); it++) {
+   delete it->second;
+ }
+}
+
+// Creates or inherits the serial bag of a task which begins.
+template <typename SetT>
+VOID SerialBagEngine<SetT>::beginTask(INTEGER taskID,
+                                      const INTVECTOR &parents,
+                                      INTEGER outDegree) {
+
+  if ( parents.empty() ) { // if no HB tasks in graph
+    // check if has no serial bag
+    if (serial_bags.find(taskID) == serial_bags.end()) {
+      auto newTaskbag = new SerialBag<SetT>();
+      // specify number of tasks dependent of this task
+      newTaskbag->outBufferCount = outDegree;
+      serial_bags[taskID] = newTaskbag;
+    }
+    return;
+  }
+
+  // has parent tasks
+  // look for the parents serial bags and inherit them
+  // or construct your own by cloning the parent's
+
+  // 1.find the parent bag which can be inherited
+  SerialBagPtr taskBag   = NULL;
+  INTEGER      inherited = -1;
+  for (auto parentID : parents) {
+
+    // take with outstr 1 and longest
+    auto curBag = serial_bags.find(parentID);
+    if (curBag == serial_bags.end()) continue; // parent never began
+
+    if (curBag->second->outBufferCount == 1) {
+      taskBag   = curBag->second;
+      inherited = parentID;
+      serial_bags.erase(curBag);
+      taskBag->HB.insert(parentID);
+      break;  // could optimize by looking all bags
+    }
+  }
+
+  if (!taskBag) {
+    taskBag = new SerialBag<SetT>(); // no bag inherited
+  }
+  // the number of inheriting bags
+  taskBag->outBufferCount = outDegree;
+
+  // 2. merge the HBs of the parent nodes
+  for (auto parentID : parents) {
+    if (parentID == inherited) continue;
+
+    auto found = serial_bags.find(parentID);
+    if (found == serial_bags.end()) continue;
+    auto aBag = found->second;
+
+    taskBag->HB.insertAll(aBag->HB); // merging...
+    taskBag->HB.insert(parentID); // parents happen-before me
+    merges++;
+    mergedElements += aBag->HB.size();
+
+    aBag->outBufferCount--; // for inheriting bags
+    if (!aBag->outBufferCount) {
+      serial_bags.erase(found);
+      delete aBag;
+    }
+  }
+
+  serial_bags[taskID] = taskBag; // 3. add the bag to serial_bags
+}
+
+template <typename SetT>
+BOOL SerialBagEngine<SetT>::happensBefore(INTEGER before,
+                                          INTEGER after) const {
+  auto bag = serial_bags.find(after);
+  if (bag == serial_bags.end()) return false;
+
+  return bag->second->HB.contains(before);
+}
+
+template <typename SetT>
+VOID SerialBagEngine<SetT>::print() const {
+  for (auto it = serial_bags.begin(); it != serial_bags.end(); it++) {
+      std::cout << it->first << " ("
+                << it->second->outBufferCount<< ", "
+                << it->second->HB.size() << " tasks): {";
+      it->second->HB.forEach([](int x) { std::cout << x << " "; });
+      std::cout << "}" << std::endl;
+  }
+}
+
+template <typename SetT>
+VOID SerialBagEngine<SetT>::save(SnapshotWriter &out) const {
+  saveCounters(out);
+  out.write<uint64_t>(serial_bags.size());
+  for (auto &bag : serial_bags) {
+    out.write<int64_t>(bag.first);
+    out.write<int32_t>(bag.second->outBufferCount);
+    out.write<uint64_t>(bag.second->HB.size());
+    bag.second->HB.forEach([&out](int taskID) {
+      out.write<int32_t>(taskID);
+    });
+  }
+}
+
+template <typename SetT>
+BOOL SerialBagEngine<SetT>::load(SnapshotReader &in) {
+  loadCounters(in);
+  uint64_t bags = in.read<uint64_t>();
+  for (uint64_t i = 0; i < bags && in.good(); i++) {
+    INTEGER taskID = in.read<int64_t>();
+    SerialBagPtr &bag = serial_bags[taskID];
+    if ( !bag ) bag = new SerialBag<SetT>();
+    bag->outBufferCount = in.read<int32_t>();
+
+    uint64_t size = in.read<uint64_t>();
+    for (uint64_t j = 0; j < size && in.good(); j++) {
+      bag->HB.insert( in.read<int32_t>() );
+    }
+  }
+  return in.good();
+}
+
+// the bags of the engines created above
+template class SerialBagEngine<HashTaskSet>;
+template class SerialBagEngine<TaskSet>;
+
+
+VOID ChainClockEngine::reserveTask(INTEGER taskID) {
+  if (taskID < static_cast<INTEGER>(chainOf.size())) return;
+
+  size_t size = std::max<size_t>(taskID + 1, chainOf.size() * 2);
+  chainOf.resize(size, -1);
+  positionOf.resize(size, 0);
+  childrenLeft.resize(size, 0);
+  clocks.resize(size);
+}
+
+VOID ChainClockEngine::releaseClock(INTEGER taskID) {
+  INTVECTOR().swap( clocks[taskID] );
+  live--;
+}
+
+VOID ChainClockEngine::beginTask(INTEGER taskID,
+                                 const INTVECTOR &parents,
+                                 INTEGER outDegree) {
+  reserveTask(taskID);
+  if (chainOf[taskID] >= 0) return; // already began
+
+  // 1. extend the chain of a parent which is the last of its chain
+  INTEGER chain    = -1;
+  INTEGER position = 1;
+  for (auto parentID : parents) {
+    if (parentID >= static_cast<INTEGER>(chainOf.size()) ||
+        chainOf[parentID] < 0) {
+      continue; // parent never began
+    }
+
+    INTEGER parentChain = chainOf[parentID];
+    if (chainEnd[parentChain] == positionOf[parentID]) {
+      chain    = parentChain;
+      position = positionOf[parentID] + 1;
+      break;
+    }
+  }
+
+  if (chain < 0) { // start a new chain
+    chain = chainEnd.size();
+    chainEnd.push_back(0);
+  }
+  chainEnd[chain]      = position;
+  chainOf[taskID]      = chain;
+  positionOf[taskID]   = position;
+  childrenLeft[taskID] = outDegree;
+
+  // 2. merge the clocks of the parents, they include the parents
+  INTVECTOR &clock = clocks[taskID];
+  for (auto parentID : parents) {
+    if (parentID >= static_cast<INTEGER>(clocks.size())) continue;
+
+    const INTVECTOR &parentClock = clocks[parentID];
+    merges++;
+    mergedElements += parentClock.size();
+    if (clock.size() < parentClock.size()) {
+      clock.resize(parentClock.size(), 0);
+    }
+    for (size_t i = 0; i < parentClock.size(); i++) {
+      clock[i] = std::max(clock[i], parentClock[i]);
+    }
+  }
+
+  if (static_cast<INTEGER>(clock.size()) <= chain) {
+    clock.resize(chain + 1, 0);
+  }
+  clock[chain] = position;
+  live++;
+
+  // 3. release the clocks of parents whose children all began
+  for (auto parentID : parents) {
+    if (parentID >= static_cast<INTEGER>(chainOf.size()) ||
+        chainOf[parentID] < 0) {
+      continue;
+    }
+    if (childrenLeft[parentID] > 0 && --childrenLeft[parentID] == 0) {
+      releaseClock(parentID);
+    }
+  }
+}
+
+BOOL ChainClockEngine::happensBefore(INTEGER before,
+                                     INTEGER after) const {
+  if (before < 0 || before >= static_cast<INTEGER>(chainOf.size()) ||
+      after  < 0 || after  >= static_cast<INTEGER>(clocks.size())) {
+    return false;
+  }
+
+  INTEGER chain = chainOf[before];
+  if (chain < 0) return false; // never began
+
+  const INTVECTOR &clock = clocks[after];
+  return chain < static_cast<INTEGER>(clock.size()) &&
+         clock[chain] >= positionOf[before];
+}
+
+VOID ChainClockEngine::print() const {
+  for (size_t taskID = 0; taskID < clocks.size(); taskID++) {
+    if ( clocks[taskID].empty() ) continue;
+
+    std::cout << taskID << " [" << chainOf[taskID] << ":"
+              << positionOf[taskID] << "] ("
+              << childrenLeft[taskID] << "): {";
+    for (auto position : clocks[taskID]) {
+      std::cout << position << " ";
+    }
+    std::cout << "}" << std::endl;
+  }
+}
+
+VOID ChainClockEngine::save(SnapshotWriter &out) const {
+  saveCounters(out);
+  out.writeVector(chainOf);
+  out.writeVector(positionOf);
+  out.writeVector(childrenLeft);
+  out.writeVector(chainEnd);
+  out.write<uint64_t>(live);
+
+  // the clocks released are empty
+  for (auto &clock : clocks) out.writeVector(clock);
+}
+
+BOOL ChainClockEngine::load(SnapshotReader &in) {
+  loadCounters(in);
+  in.readVector(chainOf);
+  in.readVector(positionOf);
+  in.readVector(childrenLeft);
+  in.readVector(chainEnd);
+  live = in.read<uint64_t>();
+
+  if (positionOf.size() != chainOf.size() ||
+      childrenLeft.size() != chainOf.size()) {
+    return false;
+  }
+  clocks.assign(chainOf.size(), INTVECTOR());
+  for (auto &clock : clocks) in.readVector(clock);
+  return in.good();
+}
@@ -0,0 +1,154 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the happens-before engines of the checker. An engine
+// learns the dependencies of each task when the task begins and
+// answers whether a task happens-before a running task.
+//
+//   SerialBagEngine:   every task has a bag with all the tasks which
+//                      happen-before it, bags are inherited or merged.
+//                      The bags are hash sets ("bags") or hybrid
+//                      sparse/dense bitsets ("bitbags").
+//   ChainClockEngine:  tasks are decomposed into chains, every task
+//                      has a clock with one entry per chain.
+
+#ifndef _DETECTOR_HBENGINE_HPP_
+#define _DETECTOR_HBENGINE_HPP_
+
+#include "defs.hpp"
+#include "taskSet.hpp"
+#include "checkpoint.hpp"
+
+class HBEngine {
+  public:
+    virtual ~HBEngine() {}
+
+    /**
+     * Called when task "taskID" begins. "parents" are the tasks
+     * it directly depends on, all of them have terminated. The
+     * state of a parent may be released after "outDegree" of its
+     * children have begun.
+     */
+    virtual VOID beginTask(INTEGER taskID, const INTVECTOR &parents,
+                           INTEGER outDegree) = 0;
+
+    /**
+     * Returns true if task "before" happens-before task "after".
+     * "after" has begun and its state is not released yet.
+     */
+    virtual BOOL happensBefore(INTEGER before, INTEGER after) const = 0;
+
+    /** Returns the number of tasks whose state is kept */
+    virtual size_t liveTasks() const = 0;
+
+    /** Prints the state of the live tasks, for testing */
+    virtual VOID print() const = 0;
+
+    /** Writes the state of the live tasks to a snapshot */
+    virtual VOID save(SnapshotWriter &out) const = 0;
+
+    /** Reads the state saved into a new engine of the same kind */
+    virtual BOOL load(SnapshotReader &in) = 0;
+
+    /** Number of HB states merged into tasks which began */
+    size_t mergeCount()  const { return merges; }
+
+    /** Total size of the HB states merged */
+    size_t mergedTasks() const { return mergedElements; }
+
+    /**
+     * Creates the engine named "kind": "bags", "bitbags"
+     * or "clocks"
+     */
+    static HBEngine *create(const std::string &kind);
+
+  protected:
+    VOID saveCounters(SnapshotWriter &out) const {
+      out.write<uint64_t>(merges);
+      out.write<uint64_t>(mergedElements);
+    }
+
+    VOID loadCounters(SnapshotReader &in) {
+      merges         = in.read<uint64_t>();
+      mergedElements = in.read<uint64_t>();
+    }
+
+    size_t merges          =  0;
+    size_t mergedElements  =  0;
+};
+
+
+// a bag to hold the tasks that happened-before
+template <typename SetT>
+struct SerialBag {
+  int             outBufferCount;
+  SetT            HB;
+
+  SerialBag(): outBufferCount(0){}
+};
+
+template <typename SetT>
+class SerialBagEngine : public HBEngine {
+  public:
+    typedef SerialBag<SetT> *SerialBagPtr;
+
+    ~SerialBagEngine();
+
+    VOID beginTask(INTEGER taskID, const INTVECTOR &parents,
+                   INTEGER outDegree) override;
+    BOOL happensBefore(INTEGER before, INTEGER after) const override;
+    size_t liveTasks() const override { return serial_bags.size(); }
+    VOID print() const override;
+    VOID save(SnapshotWriter &out) const override;
+    BOOL load(SnapshotReader &in) override;
+
+  private:
+    // hold bags of tasks
+    std::unordered_map <INTEGER, SerialBagPtr>   serial_bags;
+};
+
+
+// Chain decomposition clocks. A task extends the chain of a parent
+// if it is the first child to do so, otherwise it starts a new
+// chain. Tasks of a chain are ordered, so a clock keeps only the
+// last position of each chain which happens-before the task.
+class ChainClockEngine : public HBEngine {
+  public:
+    ChainClockEngine(): live(0) {}
+
+    VOID beginTask(INTEGER taskID, const INTVECTOR &parents,
+                   INTEGER outDegree) override;
+    BOOL happensBefore(INTEGER before, INTEGER after) const override;
+    size_t liveTasks() const override { return live; }
+    VOID print() const override;
+    VOID save(SnapshotWriter &out) const override;
+    BOOL load(SnapshotReader &in) override;
+
+  private:
+    // makes the per-task vectors large enough for "taskID"
+    VOID reserveTask(INTEGER taskID);
+
+    // releases the clock of a task
+    VOID releaseClock(INTEGER taskID);
+
+    // per task, indexed by the dense task ids
+    std::vector<INTEGER>    chainOf;      // -1 if not begun
+    std::vector<INTEGER>    positionOf;   // position in the chain, from 1
+    std::vector<INTEGER>    childrenLeft; // children not begun yet
+    std::vector<INTVECTOR>  clocks;       // last position per chain
+
+    // per chain, the position of its last task
+    std::vector<INTEGER>    chainEnd;
+    size_t                  live;
+};
+
+#endif // end hbEngine.hpp
@@ -17,13 +17,36 @@
 #define _DETECTOR_INSTRUCTION_HPP_
 
 #include "defs.hpp"
+#include <cstring>
+
+// A slice of an IR statement, the tokens are not copied
+typedef struct IRSlice {
+  const char *begin;
+  size_t      size;
+
+  IRSlice(): begin(""), size(0) {}
+  IRSlice(const char *begin_, size_t size_): begin(begin_), size(size_) {}
+
+  inline bool operator==(const char *word) const {
+    return strncmp(begin, word, size) == 0 && word[size] == '\0';
+  }
+
+  inline bool operator!=(const char *word) const {
+    return !(*this == word);
+  }
+
+  inline std::string str() const { return std::string(begin, size); }
+} IRSlice;
+
+// the tokens of an instruction used to build it
+#define IR_MAX_TOKENS 8
 
 class Instruction {
   public:
   INTEGER        lineNo;
   std::string    destination;
   std::string    type;
-  OPERATION      oper;
+  OPERATION      oper = UNKNOWN;
   std::string    operand1;
   std::string    operand2;
 
@@ -40,47 +63,33 @@ class Instruction {
    * an instruction and constructs an object representaion
    * of it.
    */
-  Instruction(std::string stmt) {
+  Instruction(const std::string &stmt) {
 
   raw = trim( stmt );
-  std::vector<std::string> contents = splitInstruction( raw );
+  IRSlice contents[IR_MAX_TOKENS];
+  splitInstruction( raw, contents );
 
   if (contents[0] == "store") {
     oper        = STORE;
-    destination = contents[4];
-    operand1    = contents[2];
-    operand2    = contents[2];
-    type        = contents[1];
+    destination = contents[4].str();
+    operand1    = contents[2].str();
+    operand2    = contents[2].str();
+    type        = contents[1].str();
   } else if (contents[2] == "load") {
     oper        = LOAD;
-    destination = contents[0];
-    operand1    = contents[5];
-    type        = contents[3];
-  } else if (std::regex_search(contents[2], std::regex("[fidb]add")) ||
-             std::regex_search(contents[2], std::regex("[fidb]sub")) ||
-             std::regex_search(contents[2], std::regex("[fidb]mul")) ||
-             std::regex_search(contents[2], std::regex("[fidb]div"))) {
-    destination = contents[0];
-    type        = contents[3];
-    operand1    = contents[4];
-    operand2    = contents[5];
-    if (std::regex_search(contents[2], std::regex("[fidb]add"))) {
-      oper = ADD;
-    } else if (std::regex_search(contents[2],
-        std::regex("[fidb]sub"))) {
-      oper = SUB;
-    } else if (std::regex_search(contents[2],
-        std::regex("[fidb]mul"))) {
-      oper = MUL;
-    } else if (std::regex_search(contents[2],
-        std::regex("[fidb]div"))) {
-      oper = DIV;
-    }
+    destination = contents[0].str();
+    operand1    = contents[5].str();
+    type        = contents[3].str();
+  } else if (isTypedArithmetic(contents[2])) {
+    destination = contents[0].str();
+    type        = contents[3].str();
+    operand1    = contents[4].str();
+    operand2    = contents[5].str();
     // ...
 
   } else if (contents[2] == "add" || contents[2] == "sub" ||
             contents[2] == "mul" || contents[2] == "shl") {
-     destination = contents[0];
+     destination = contents[0].str();
      oper        = (contents[2] == "add")
                    ? ADD
                    : ((contents[2] == "sub")
@@ -92,61 +101,33 @@ class Instruction {
 
      // <result> = add nuw nsw <ty> <op1>, <op2>  ; yields {ty}:result
      if (contents[3] == "nuw" && contents[4] == "nsw") {
-        type     = contents[5];
-        operand1 = contents[6];
-        operand2 = contents[7];
+        type     = contents[5].str();
+        operand1 = contents[6].str();
+        operand2 = contents[7].str();
      } else if (contents[3] == "nuw" || contents[3] == "nsw") {
         // <result> = add nuw <ty> <op1>, <op2>    ; yields {ty}:result
         // <result> = add nsw <ty> <op1>, <op2>    ; yields {ty}:result
-        type     = contents[4];
-        operand1 = contents[5];
-        operand2 = contents[6];
+        type     = contents[4].str();
+        operand1 = contents[5].str();
+        operand2 = contents[6].str();
      } else {
         // <result> = add <ty> <op1>, <op2>        ; yields {ty}:result
-        type     = contents[3];
-        operand1 = contents[4];
-        operand2 = contents[5];
+        type     = contents[3].str();
+        operand1 = contents[4].str();
+        operand2 = contents[5].str();
      }
   } else if (contents[2] == "alloca") {
-    destination = contents[0];
+    destination = contents[0].str();
     oper        = ALLOCA;
-    type        = contents[3];
+    type        = contents[3].str();
   } else if (contents[2] == "bitcast") {
-    destination = contents[0];
+    destination = contents[0].str();
     oper        = BITCAST;
-    operand1    = contents[4];
-    operand2    = contents[4];
+    operand1    = contents[4].str();
+    operand2    = contents[4].str();
   } else if (contents[0] == "call") {
     oper = CALL;
   }
-
-  /*
-  // find operation
-  if (std::regex_search(segments[0], std::regex("store ")) {
-     oper = STORE;
-     std::string tmp = ;
-     std::stringstream a(trim(segments[0]));
-     tmp = ""'
-     (getline(ss, tok, ','); //store
-  }
-  if (std::regex_search(segments[0], std::regex("load "))
-     oper = LOAD;
-
-  if (std::regex_search(segments[0], std::regex("call "))
-     oper = CALL;
-
-  if (std::regex_search(segments[0], std::regex("alloca "))
-     oper = ALLOCA;
-
-  if (std::regex_search(segments[0], std::regex("bitcast "))
-     oper = BITCAST;
-
-  if (std::regex_search(segments[0], std::regex("[fidb]add "))
-     oper = ADD;
-
-  if (std::regex_search(segments[0], std::regex("[fidb]mull "))
-     oper = MULT;
-  */
 }
 
   void print() {
@@ -162,35 +143,64 @@ class Instruction {
   /**
    * Trims the left and right spaces from a string.
    */
-  static std::string trim(std::string sentence) {
+  static std::string trim(const std::string &sentence) {
     size_t start = sentence.find_first_not_of(' ');
+    if (start == std::string::npos) return std::string();
     size_t end   = sentence.find_last_not_of(' ');
     return sentence.substr(start, (end -start)+1);
   }
 
   /**
-   * Splits string into tokens substrings
+   * Splits the statement into its first IR_MAX_TOKENS words in
+   * one pass. Words are separated by a space or by a comma and
+   * the spaces around it; the tokens not present are empty.
    */
-  std::vector<std::string> splitInstruction(std::string stmt) {
-
-    // split statements
-    std::vector<std::string>  segments;
-    std::stringstream         ss( stmt ); // make string stream.
-    std::string               tok;
-
-    while (getline(ss, tok, ',')) {
-      segments.push_back(tok);
+  static VOID splitInstruction(const std::string &stmt,
+                               IRSlice *tokens) {
+    const char *pos = stmt.c_str();
+    const char *end = pos + stmt.size();
+    size_t count = 0;
+
+    while (pos < end && count < IR_MAX_TOKENS) {
+      // a segment between commas, without its spaces around
+      const char *comma = static_cast<const char *>(
+          memchr(pos, ',', end - pos));
+      const char *segmentEnd = comma ? comma : end;
+      while (pos < segmentEnd && *pos == ' ') pos++;
+      const char *last = segmentEnd;
+      while (last > pos && last[-1] == ' ') last--;
+
+      // words of the segment, consecutive spaces give empty words
+      while (pos < last && count < IR_MAX_TOKENS) {
+        const char *space = static_cast<const char *>(
+            memchr(pos, ' ', last - pos));
+        const char *wordEnd = space ? space : last;
+        tokens[count++] = IRSlice(pos, wordEnd - pos);
+        pos = space ? space + 1 : last;
+      }
+      pos = segmentEnd + 1;
     }
+  }
 
-    std::vector<std::string> segments2;
-    // make individual words
-    for (auto stmt : segments) {
-      std::stringstream sg2(trim(stmt));
-      while ( getline(sg2, tok, ' ') ) {
-        segments2.push_back(tok);
+  private:
+  /**
+   * Sets "oper" and returns true for the typed arithmetic
+   * operations, such as fadd or idiv
+   */
+  bool isTypedArithmetic(const IRSlice &word) {
+    static const char *names[] = { "add", "sub", "mul", "div" };
+    static const OPERATION opers[] = { ADD, SUB, MUL, DIV };
+
+    for (size_t i = 0; i < 4; i++) {
+      for (size_t at = 1; at + 3 <= word.size; at++) {
+        if (strchr("fidb", word.begin[at - 1]) &&
+            memcmp(word.begin + at, names[i], 3) == 0) {
+          oper = opers[i];
+          return true;
+        }
       }
     }
-    return segments2;
+    return false;
   }
 };
 
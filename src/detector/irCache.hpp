@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the binary cache of a parsed IRlog file, written next to
+// it as "IRlog.cache". The cache starts with a FileHeader holding
+// the hash of the IRlog it was made from, followed by the task
+// records, the instruction records of the tasks parsed and the
+// strings they refer to. A cache whose hash differs from the IRlog
+// is stale and ignored.
+//
+// Only the tasks which were validated are parsed, so a task record
+// also locates its body in the IRlog. Tasks without instruction
+// records are parsed from there when first used, and the cache is
+// written again with them.
+
+#ifndef _DETECTOR_IRCACHE_HPP_
+#define _DETECTOR_IRCACHE_HPP_
+
+#include "defs.hpp"
+#include <cstdint>
+#include <cstring>
+
+// appended to the IRlog name
+#define IRCACHE_SUFFIX ".cache"
+
+namespace IRCache {
+
+  const char      MAGIC[8]  = { 'D', 'F', 'I', 'R', 'C', 'A', 'C', 'H' };
+  const uint32_t  VERSION   = 2;
+  const uint32_t  BYTEORDER = 0x01020304;
+
+  // a string of the string table
+  typedef struct StringRef {
+    uint32_t  offset;
+    uint32_t  size;
+  } StringRef;
+
+  typedef struct FileHeader {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  byteOrder;
+    uint64_t  sourceHash;   // of the IRlog contents
+    uint64_t  sourceSize;
+    uint32_t  tasks;        // task records
+    uint32_t  instructions; // instruction records
+    uint32_t  recordSize;
+    uint32_t  stringsSize;  // bytes of the string table
+
+    FileHeader(): magic(), version(VERSION), byteOrder(BYTEORDER),
+                  sourceHash(0), sourceSize(0), tasks(0),
+                  instructions(0), recordSize(0), stringsSize(0) {
+      memcpy(magic, MAGIC, sizeof(magic));
+    }
+  } FileHeader;
+
+  // a task, the range of its instruction records if it was
+  // parsed, and its body in the IRlog
+  typedef struct TaskRecord {
+    StringRef  name;
+    uint32_t   first;
+    uint32_t   count;
+    uint32_t   parsed;     // 0 if it has no instruction records
+    uint32_t   reserved;
+    uint64_t   textOffset;
+    uint64_t   textSize;
+  } TaskRecord;
+
+  // the fields of an Instruction
+  typedef struct InstructionRecord {
+    int32_t    oper;
+    int32_t    lineNo;
+    StringRef  destination;
+    StringRef  type;
+    StringRef  operand1;
+    StringRef  operand2;
+    StringRef  raw;
+  } InstructionRecord;
+
+  /**
+   * Hashes "size" bytes with FNV-1a, taking 8 bytes at a time
+   * to keep up with large IRlog files.
+   */
+  inline uint64_t hash(const char *data, size_t size) {
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t value = 14695981039346656037ULL;
+
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data, sizeof(word));
+      value = (value ^ word) * prime;
+      data += sizeof(word);
+    }
+    for (; size > 0; size--) {
+      value = (value ^ static_cast<unsigned char>(*data++)) * prime;
+    }
+    return value;
+  }
+
+  /** Checks whether the header describes a cache of the IRlog */
+  inline bool isValidHeader(const FileHeader &header, size_t fileSize,
+                            uint64_t sourceHash, uint64_t sourceSize) {
+    if (fileSize < sizeof(FileHeader) ||
+        memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.version    != VERSION   ||
+        header.byteOrder  != BYTEORDER ||
+        header.recordSize != sizeof(InstructionRecord) ||
+        header.sourceHash != sourceHash ||
+        header.sourceSize != sourceSize) {
+      return false;
+    }
+    return fileSize == sizeof(FileHeader) +
+                       header.tasks * sizeof(TaskRecord) +
+                       header.instructions * sizeof(InstructionRecord) +
+                       static_cast<size_t>(header.stringsSize);
+  }
+
+} // end namespace
+
+#endif // end irCache.hpp
@@ -14,14 +14,35 @@
 
 #include "checker.hpp"  // header
 #include "validator.hpp"
+#include "binaryTrace.hpp"
+#include "textTrace.hpp"
+#include "shardedTrace.hpp"
+#include "streamReader.hpp"
+#include "options.hpp"
+#include "profiler.hpp"
+
+// reads the HBlog and the trace, timing each
+template<typename Reader>
+static BOOL readLogs(Reader &reader, const CheckerOptions &options,
+                     Checker &checker, Profiler &profiler) {
+  profiler.beginPhase("hb_load");
+  if ( !reader.readHBlog(options.HBlog, checker) ) return false;
+  uint64_t hbEvents = checker.eventCount();
+  profiler.endPhase(hbEvents);
+
+  profiler.beginPhase("trace");
+  BOOL loaded = reader.readTrace(options.traceLog, checker);
+  profiler.endPhase(checker.eventCount() - hbEvents);
+  return loaded;
+}
 
 int main(int argc, char * argv[]) {
 
-  if (argc != 4) {
+  CheckerOptions options;
+  if ( !options.parse(argc, argv) ) {
     std::cout << std::endl;
     std::cout << "ERROR!" << std::endl;
-    std::cout << "Usage: ./DFchecker TraceLog.txt HBlog.txt IRlog.txt"
-              << std::endl;
+    CheckerOptions::printUsage();
     std::cout << std::endl;
     exit(-1);
   }
@@ -30,44 +51,64 @@ int main(int argc, char * argv[]) {
   std::chrono::high_resolution_clock::time_point t1 =
       std::chrono::high_resolution_clock::now();
 
-  Checker aChecker; // checker instance
-  std::string logLine;
+  Profiler profiler; // timed phases, written if --profile
+  NameInterner names; // shared by the checker and the validator
+  Checker aChecker( options, names ); // checker instance
 
-  std::ifstream HBlog(argv[2]); //  hb file
-  // check if HBlog file successfully opened
-  if (!HBlog.is_open()) {
+  // continue from a snapshot of an earlier run
+  if (options.resume && !aChecker.resume(options.resume)) {
     std::cout << "ERROR!" << std::endl;
-    std::cout << "HBlog file: " << argv[2]
-              << " could not open." << std::endl;
     exit(-1);
   }
 
-  while ( getline(HBlog, logLine) ) {
-    aChecker.addTaskNode(logLine);
+  // binary logs and manifests of shards are detected from their header
+  BOOL loaded = false;
+  if ( options.stream ) { // online, while the program runs
+    StreamReader reader;
+    profiler.beginPhase("stream");
+    loaded = reader.read(options.stream, aChecker);
+    profiler.endPhase( aChecker.eventCount() );
+  } else if ( ShardedTraceReader::isManifest(options.HBlog) ) {
+    ShardedTraceReader reader;
+    loaded = readLogs(reader, options, aChecker, profiler);
+  } else if ( BinaryTraceReader::isBinaryLog(options.HBlog) ) {
+    BinaryTraceReader reader;
+    loaded = readLogs(reader, options, aChecker, profiler);
+  } else {
+    TextTraceReader reader;
+    loaded = readLogs(reader, options, aChecker, profiler);
   }
-  HBlog.close();
 
-  std::ifstream log(argv[1]); //  log file
-  // check if trace file successfully opened
-  if (!log.is_open()) {
+  if ( !loaded ) {
     std::cout << "ERROR!" << std::endl;
-    std::cout << "Trace file: " << argv[1]
-              << " could not open." << std::endl;
+    if ( options.stream ) {
+      std::cout << "Stream: " << options.stream
+                << " could not be read." << std::endl;
+    } else {
+      std::cout << "Logs: " << options.traceLog << ", " << options.HBlog
+                << " could not be read." << std::endl;
+    }
     exit(-1);
   }
 
-  while ( getline(log, logLine) ) {
-    // processes log file and detects nondeterminism
-    aChecker.processLogLines(logLine);
-  }
-  log.close();
+  // the accesses queued for the threads, and those checked before
+  double readChecks = aChecker.checkSeconds();
+  profiler.beginPhase("detection");
+  aChecker.finishChecking();
+  profiler.endPhase();
+  profiler.moveSeconds(options.stream ? "stream" : "trace", "detection",
+                       readChecks);
 
   // validate the detected nondeterminism bugs
-  BugValidator validator;
-  validator.parseTasksIR( argv[3] ); // read IR file
+  BugValidator validator( names );
+  profiler.beginPhase("ir_index");
+  validator.indexTasksIR( options.IRlog ); // index IR file
+  profiler.endPhase();
 
   // do the validation to eliminate commutative operations
+  profiler.beginPhase("validation");
   aChecker.checkCommutativeOperations( validator );
+  profiler.endPhase();
 
   // take time at end of analyis
   std::chrono::high_resolution_clock::time_point t2 =
@@ -75,13 +116,29 @@ int main(int argc, char * argv[]) {
   auto duration = std::chrono::duration_cast<std::chrono::microseconds>
       ( t2 - t1 ).count();
 
+  // keep the parsed IR for the next runs
+  profiler.beginPhase("ir_cache_write");
+  validator.writeIRcache();
+  profiler.endPhase();
+
   // testing writes
   //aChecker.testing();
+  profiler.beginPhase("report");
   aChecker.reportConflicts();
   aChecker.printHBGraph();
   aChecker.printHBGraphJS(); // print in JS format
+  profiler.endPhase();
 
   std::cout << "Checker execution time: "<< duration/1000.0
             << " milliseconds" << std::endl;
+
+  if ( options.profile ) {
+    aChecker.addCounters(profiler);
+    validator.addCounters(profiler);
+    if ( !profiler.write(options.profile) ) {
+      std::cout << "ERROR! Profile: " << options.profile
+                << " could not be written." << std::endl;
+    }
+  }
   return 0;
 }
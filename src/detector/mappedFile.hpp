@@ -0,0 +1,81 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines a read-only memory mapping of a whole file. The log
+// readers scan the mapping in place, so the logs never have to
+// be copied into heap memory.
+
+#ifndef _DETECTOR_MAPPEDFILE_HPP_
+#define _DETECTOR_MAPPEDFILE_HPP_
+
+#include "defs.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+  public:
+    MappedFile(): fd(-1), start(NULL), length(0) {}
+
+    ~MappedFile() { close(); }
+
+    /** Maps the file, returns false if it can not be opened */
+    BOOL open(const char *fileName) {
+      close();
+      fd = ::open(fileName, O_RDONLY);
+      if (fd < 0) return false;
+
+      struct stat info;
+      if (fstat(fd, &info) != 0) {
+        close();
+        return false;
+      }
+
+      length = static_cast<size_t>(info.st_size);
+      if ( !length ) return true; // nothing to map
+
+      void *mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+        close();
+        return false;
+      }
+
+      // the logs are scanned once from the beginning to the end
+      madvise(mapping, length, MADV_SEQUENTIAL);
+      start = static_cast<const char *>(mapping);
+      return true;
+    }
+
+    VOID close() {
+      if ( start ) munmap(const_cast<char *>(start), length);
+      if (fd >= 0) ::close(fd);
+      fd     = -1;
+      start  = NULL;
+      length = 0;
+    }
+
+    const char *begin() const { return start; }
+    const char *end()   const { return start + length; }
+    size_t      size()  const { return length; }
+
+  private:
+    // mappings can not be copied
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    int          fd;
+    const char  *start;
+    size_t       length;
+};
+
+#endif // end mappedFile.hpp
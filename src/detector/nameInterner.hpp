@@ -0,0 +1,76 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the interner of the task and function names. Every
+// distinct name is stored once and identified by a small integer,
+// so names are compared and hashed as integers. The checker and
+// the validator share one interner.
+
+#ifndef _DETECTOR_NAMEINTERNER_HPP_
+#define _DETECTOR_NAMEINTERNER_HPP_
+
+#include "defs.hpp"
+#include "checkpoint.hpp"
+
+class NameInterner {
+  public:
+    /** Returns the id of "name", adding it if new */
+    inline INTEGER intern(const std::string &name) {
+      auto found = ids.find(name);
+      if (found != ids.end()) return found->second;
+
+      INTEGER id = names.size();
+      auto added = ids.insert( std::make_pair(name, id) ).first;
+      names.push_back( &added->first ); // the keys do not move
+      return id;
+    }
+
+    /** Returns the id of "name", or -1 if it was never added */
+    inline INTEGER find(const std::string &name) const {
+      auto found = ids.find(name);
+      return (found != ids.end()) ? found->second : -1;
+    }
+
+    /** Returns the name of "id", empty for -1 */
+    inline const std::string &name(INTEGER id) const {
+      static const std::string unknown;
+      if (id < 0 || id >= static_cast<INTEGER>(names.size())) {
+        return unknown;
+      }
+      return *names[id];
+    }
+
+    inline size_t size() const { return names.size(); }
+
+    /** Writes the names in the order of their ids */
+    VOID save(SnapshotWriter &out) const {
+      out.write<uint64_t>(names.size());
+      for (auto name : names) out.writeString(*name);
+    }
+
+    /** Reads the names saved, the interner must be empty */
+    BOOL load(SnapshotReader &in) {
+      uint64_t count = in.read<uint64_t>();
+      std::string name;
+      for (uint64_t id = 0; id < count && in.good(); id++) {
+        in.readString(name);
+        if (intern(name) != static_cast<INTEGER>(id)) return false;
+      }
+      return in.good();
+    }
+
+  private:
+    std::unordered_map<std::string, INTEGER>  ids;
+    std::vector<const std::string *>          names; // per id
+};
+
+#endif // end nameInterner.hpp
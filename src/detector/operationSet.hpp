@@ -58,6 +58,24 @@ class OperationSet {
       return true;
     }
 
+    /**
+     * Returns a bit for each group of operations in the set:
+     * 1 for additions and subtractions, 2 for the others.
+     */
+    unsigned groups() const {
+      unsigned mask = 0;
+      for (auto i = operations.begin(); i != operations.end(); i++) {
+        mask |= (*i == ADD || *i == SUB) ? 1 : 2;
+      }
+      return mask;
+    }
+
+    /** Checks if operations of two sets of groups commute */
+    static bool commute(unsigned groups1, unsigned groups2) {
+      unsigned mask = groups1 | groups2;
+      return (mask & (mask - 1)) == 0; // one group at most
+    }
+
   private:
   std::set<OPERATION> operations;
 };
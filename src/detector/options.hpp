@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the command line options of the checker.
+
+#ifndef _DETECTOR_OPTIONS_HPP_
+#define _DETECTOR_OPTIONS_HPP_
+
+#include "defs.hpp"
+#include "shadowMemory.hpp"
+#include <cstdlib>
+#include <cstring>
+
+class CheckerOptions {
+  public:
+    unsigned    threads   =  1;    // -j N: threads for conflict detection
+    std::string hbEngine  =  "clocks"; // --hb=clocks|bags|bitbags
+    unsigned    historyDepth = 5;  // --history-depth N: accesses per address
+    BOOL        exact     =  false; // --exact: summarized full history
+
+    // --max-conflicts-per-pair N: conflicts kept per task pair, all
+    // if 0. Conflicts on new pairs of lines are kept beyond N.
+    unsigned    maxConflicts = 0;
+
+    // --stream PATH: check the events of a running program, read
+    // from the FIFO PATH, the local socket "unix:PATH" or the ring
+    // file "ring:PATH"
+    const char *stream    =  NULL;
+
+    // --profile FILE: write the time and memory of the checker
+    // phases, and its counters, to FILE as JSON
+    const char *profile   =  NULL;
+
+    // --checkpoint FILE: save the state of the checker to FILE at
+    // the end of a task, every --checkpoint-every N trace events
+    const char *checkpoint = NULL;
+    unsigned    checkpointEvery = 10000000;
+
+    // --resume FILE: continue from a snapshot, at the next event
+    // of the trace after it, e.g. a trace which grew
+    const char *resume    =  NULL;
+
+    // the log files
+    const char *traceLog  =  NULL;
+    const char *HBlog     =  NULL;
+    const char *IRlog     =  NULL;
+
+    /**
+     * Parses "[options] TraceLog.txt HBlog.txt IRlog.txt", or
+     * "[options] --stream PATH IRlog.txt".
+     * Returns false if the command line is not valid.
+     */
+    BOOL parse(int argc, char *argv[]) {
+      std::vector<const char *> files;
+
+      for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (strcmp(arg, "-j") == 0) {
+          if (++i >= argc || !parseCount(argv[i], threads)) return false;
+        } else if (strncmp(arg, "-j", 2) == 0) {
+          if ( !parseCount(arg + 2, threads) ) return false;
+        } else if (strncmp(arg, "--hb=", 5) == 0) {
+          hbEngine = arg + 5;
+          if (hbEngine != "clocks" && hbEngine != "bags" &&
+              hbEngine != "bitbags") {
+            std::cout << "Unknown happens-before engine: "
+                      << hbEngine << std::endl;
+            return false;
+          }
+        } else if (strncmp(arg, "--history-depth=", 16) == 0) {
+          if (!parseCount(arg + 16, historyDepth) ||
+              historyDepth > SHADOW_MAX_DEPTH) {
+            return false;
+          }
+        } else if (strcmp(arg, "--history-depth") == 0) {
+          if (++i >= argc || !parseCount(argv[i], historyDepth) ||
+              historyDepth > SHADOW_MAX_DEPTH) {
+            return false;
+          }
+        } else if (strncmp(arg, "--max-conflicts-per-pair=", 25) == 0) {
+          if ( !parseCount(arg + 25, maxConflicts) ) return false;
+        } else if (strcmp(arg, "--max-conflicts-per-pair") == 0) {
+          if (++i >= argc || !parseCount(argv[i], maxConflicts)) {
+            return false;
+          }
+        } else if (strcmp(arg, "--exact") == 0) {
+          exact = true;
+        } else if (strcmp(arg, "--stream") == 0) {
+          if (++i >= argc) return false;
+          stream = argv[i];
+        } else if (strcmp(arg, "--profile") == 0) {
+          if (++i >= argc) return false;
+          profile = argv[i];
+        } else if (strcmp(arg, "--checkpoint") == 0) {
+          if (++i >= argc) return false;
+          checkpoint = argv[i];
+        } else if (strncmp(arg, "--checkpoint-every=", 19) == 0) {
+          if ( !parseCount(arg + 19, checkpointEvery) ) return false;
+        } else if (strcmp(arg, "--checkpoint-every") == 0) {
+          if (++i >= argc || !parseCount(argv[i], checkpointEvery)) {
+            return false;
+          }
+        } else if (strcmp(arg, "--resume") == 0) {
+          if (++i >= argc) return false;
+          resume = argv[i];
+        } else if (arg[0] == '-') {
+          std::cout << "Unknown option: " << arg << std::endl;
+          return false;
+        } else {
+          files.push_back(arg);
+        }
+      }
+
+      if ( stream ) { // snapshots need the offsets in the trace
+        if (files.size() != 1 || checkpoint || resume) return false;
+        IRlog = files[0];
+        return true;
+      }
+
+      if (files.size() != 3) return false;
+      traceLog = files[0];
+      HBlog    = files[1];
+      IRlog    = files[2];
+      return true;
+    }
+
+    static VOID printUsage() {
+      std::cout << "Usage: ./DFchecker [options] "
+                << "TraceLog.txt HBlog.txt IRlog.txt" << std::endl;
+      std::cout << "       ./DFchecker [options] --stream PATH IRlog.txt"
+                << std::endl;
+      std::cout << "Options:" << std::endl;
+      std::cout << "  -j N         check conflicts with N threads"
+                << std::endl;
+      std::cout << "  --hb=KIND    happens-before engine: clocks "
+                << "(chain clocks, default), bags (serial bags) or"
+                << std::endl;
+      std::cout << "               bitbags (serial bags kept as "
+                << "bitsets when dense)" << std::endl;
+      std::cout << "  --history-depth N  accesses kept per address "
+                << "(default 5)" << std::endl;
+      std::cout << "  --exact      keep a summary of all accesses per "
+                << "address instead of the last N" << std::endl;
+      std::cout << "  --max-conflicts-per-pair N  conflicts kept per "
+                << "task pair, plus one per" << std::endl;
+      std::cout << "               new pair of lines (default all)"
+                << std::endl;
+      std::cout << "  --stream PATH  check a running program which "
+                << "streams its events to the" << std::endl;
+      std::cout << "               FIFO PATH, the local socket "
+                << "unix:PATH or the shared ring" << std::endl;
+      std::cout << "               file ring:PATH (DFINSPEC_STREAM)"
+                << std::endl;
+      std::cout << "  --checkpoint FILE  save the checker state to FILE "
+                << "every N trace events," << std::endl;
+      std::cout << "               at the end of a task "
+                << "(--checkpoint-every N, default 10000000)"
+                << std::endl;
+      std::cout << "  --resume FILE  continue from the snapshot FILE, "
+                << "at the next event of the trace" << std::endl;
+      std::cout << "  --profile FILE  write the time and memory of "
+                << "each phase and the checker" << std::endl;
+      std::cout << "               counters to FILE as JSON" << std::endl;
+    }
+
+  private:
+    // parses a positive number
+    static BOOL parseCount(const char *text, unsigned &count) {
+      char *end;
+      unsigned long value = strtoul(text, &end, 10);
+      if (*text == '\0' || *end != '\0' || value == 0) return false;
+      count = static_cast<unsigned>(value);
+      return true;
+    }
+};
+
+#endif // end options.hpp
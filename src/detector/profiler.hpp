@@ -0,0 +1,173 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the profiler of the checker phases (--profile FILE). A
+// phase records its wall time, the items it processed and the
+// resident memory of the checker when it began and ended; the peak
+// is only known for the whole run. Counters describe the state of
+// the checker. Both are written as a JSON file, e.g.
+//
+//   { "version": 2, "seconds": 1.2, "peak_rss_bytes": 191234048,
+//     "phases": [ { "name": "trace", "seconds": 0.5,
+//                   "items": 14000000, "items_per_second": 2.8e+07,
+//                   "rss_begin_bytes": 9000000,
+//                   "rss_end_bytes": 150000000 }, ... ],
+//     "counters": { "tasks": 20000, ... } }
+//
+// A single thread checks the accesses while the trace is read, and
+// the threads check the queued ones when the queue is full. This
+// time (estimated from a sample of the checks of a single thread)
+// is moved from "trace" (or "stream") to "detection", which
+// is then all the time spent checking accesses, and "trace" the
+// time spent reading the trace and updating the HB engine.
+
+#ifndef _DETECTOR_PROFILER_HPP_
+#define _DETECTOR_PROFILER_HPP_
+
+#include "defs.hpp"
+#include <cstdint>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// the version of the profile format
+#define PROFILE_VERSION 2
+
+class Profiler {
+  public:
+    Profiler(): started(now()), current(-1) {}
+
+    /** Starts timing the phase "name", ending the current one */
+    VOID beginPhase(const char *name) {
+      if (current >= 0) endPhase();
+      Phase phase;
+      phase.name     = name;
+      phase.begin    = now();
+      phase.seconds  = 0;
+      phase.items    = 0;
+      phase.beginRSS = currentMemory();
+      phase.endRSS   = 0;
+      phases.push_back(phase);
+      current = phases.size() - 1;
+    }
+
+    /** Ends the current phase, which processed "items" items */
+    VOID endPhase(uint64_t items = 0) {
+      if (current < 0) return;
+      Phase &phase  = phases[current];
+      phase.seconds = seconds(phase.begin, now());
+      phase.items   = items;
+      phase.endRSS  = currentMemory();
+      current = -1;
+    }
+
+    /**
+     * Moves "secs" of the last phase "from" to the last phase "to",
+     * for work timed by the checker within another phase
+     */
+    VOID moveSeconds(const char *from, const char *to, double secs) {
+      Phase *source = lastPhase(from), *target = lastPhase(to);
+      if ( !source || !target ) return;
+      secs = std::min(secs, source->seconds);
+      source->seconds -= secs;
+      target->seconds += secs;
+    }
+
+    /** Sets the counter "name" */
+    VOID setCounter(const std::string &name, double value) {
+      for (auto &counter : counters) {
+        if (counter.first == name) {
+          counter.second = value;
+          return;
+        }
+      }
+      counters.push_back( std::make_pair(name, value) );
+    }
+
+    /** Writes the phases and the counters, false on error */
+    BOOL write(const char *fileName) {
+      endPhase();
+      std::ofstream out(fileName);
+      if ( !out.is_open() ) return false;
+
+      out.precision(12);
+      out << "{\n  \"version\": " << PROFILE_VERSION << ",\n"
+          << "  \"seconds\": " << seconds(started, now()) << ",\n"
+          << "  \"peak_rss_bytes\": " << peakMemory() << ",\n"
+          << "  \"phases\": [";
+      for (size_t i = 0; i < phases.size(); i++) {
+        const Phase &phase = phases[i];
+        out << (i ? ",\n" : "\n")
+            << "    { \"name\": \"" << phase.name << "\", "
+            << "\"seconds\": " << phase.seconds << ", "
+            << "\"items\": " << phase.items << ", "
+            << "\"items_per_second\": "
+            << (phase.seconds > 0 ? phase.items / phase.seconds : 0)
+            << ", \"rss_begin_bytes\": " << phase.beginRSS
+            << ", \"rss_end_bytes\": " << phase.endRSS << " }";
+      }
+      out << "\n  ],\n  \"counters\": {";
+      for (size_t i = 0; i < counters.size(); i++) {
+        out << (i ? ",\n" : "\n") << "    \"" << counters[i].first
+            << "\": " << counters[i].second;
+      }
+      out << "\n  }\n}\n";
+      out.close();
+      return !out.fail();
+    }
+
+    /** Returns the peak resident memory of the checker in bytes */
+    static size_t peakMemory() {
+      struct rusage usage;
+      if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+      return static_cast<size_t>(usage.ru_maxrss) * 1024; // KB
+    }
+
+    /** Returns the resident memory of the checker now in bytes */
+    static size_t currentMemory() {
+      std::ifstream statm("/proc/self/statm");
+      size_t size = 0, resident = 0; // in pages
+      if ( !(statm >> size >> resident) ) return 0;
+      return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+  private:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    typedef struct Phase {
+      std::string  name;
+      TimePoint    begin;
+      double       seconds;
+      uint64_t     items;
+      size_t       beginRSS;
+      size_t       endRSS;
+    } Phase;
+
+    inline Phase *lastPhase(const char *name) {
+      for (size_t i = phases.size(); i > 0; i--) {
+        if (phases[i - 1].name == name) return &phases[i - 1];
+      }
+      return NULL;
+    }
+
+    static inline TimePoint now() { return std::chrono::steady_clock::now(); }
+
+    static inline double seconds(TimePoint begin, TimePoint end) {
+      return std::chrono::duration<double>(end - begin).count();
+    }
+
+    TimePoint                                   started;
+    std::vector<Phase>                          phases;
+    INTEGER                                     current; // -1 if none
+    std::vector<std::pair<std::string, double>> counters; // in order
+};
+
+#endif // end profiler.hpp
@@ -0,0 +1,333 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the shadow memory of the checker: the recent accesses
+// of every address checked. The slots of the addresses are kept in
+// pages, found through a two-level directory: the upper bits of an
+// address index a fixed array of tables, the middle bits a slot of
+// the table holding the page, and the lower bits the slot in the
+// page. The arrays are zeroed by the system as they are touched, so
+// the parts of the address space not accessed cost no memory. The
+// few addresses above the 47 bits of user space are kept in a hash
+// map of pages instead. The first access to a slot gives it a ring
+// buffer of "depth" records from a chunked pool, so no memory is
+// allocated per access and the oldest record is overwritten once
+// the ring is full. The truncated histories are counted.
+
+#ifndef _DETECTOR_SHADOWMEMORY_HPP_
+#define _DETECTOR_SHADOWMEMORY_HPP_
+
+#include "defs.hpp"
+#include "action.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <unordered_map>
+
+// a memory access kept in the history of an address
+struct AccessRecord {
+  VALUE    value;    // value read or written
+  int32_t  taskId;
+  int32_t  funcId;
+  int32_t  lineNo;
+  bool     isWrite;
+
+  AccessRecord() {}
+
+  explicit AccessRecord(const Action &action)
+      : value(action.value), taskId(action.taskId),
+        funcId(action.funcId), lineNo(action.lineNo),
+        isWrite(action.isWrite) {}
+
+  // the action of the record, for reporting
+  Action toAction(ADDRESS addr) const {
+    Action action(taskId, addr, value, lineNo, funcId);
+    action.isWrite = isWrite;
+    return action;
+  }
+};
+
+// address bits which select a slot in a page
+#define SHADOW_PAGE_BITS   9
+#define SHADOW_PAGE_SLOTS  (1 << SHADOW_PAGE_BITS)
+
+// address bits which select a page in a table, and a table in the
+// directory: together they cover addresses of 47 bits
+#define SHADOW_TABLE_BITS      19
+#define SHADOW_TABLE_PAGES     (1UL << SHADOW_TABLE_BITS)
+#define SHADOW_DIRECTORY_BITS  19
+#define SHADOW_DIRECTORY_SIZE  (1UL << SHADOW_DIRECTORY_BITS)
+
+// a write kept in the summary of an address
+struct SummaryWrite {
+  AccessRecord  access;
+  VALUE         laterValue;  // of the first later write, if overwritten
+  bool          overwritten; // by a later write of another value
+
+  SummaryWrite() {}
+
+  explicit SummaryWrite(const AccessRecord &access_)
+      : access(access_), laterValue(0), overwritten(false) {}
+};
+
+// The summary of the accesses of an address (--exact), in the
+// manner of FastTrack: the last write, and the reads which no later
+// read happens-after. A write ordered before a later one is kept
+// until later writes stand for it: one of the same value, or two of
+// different values. The first of these is remembered by its value,
+// since the engines only order past tasks before a running one.
+// Usually one or two writes are kept, whatever the number of
+// accesses.
+//
+// An access which races with a dropped access races with a kept
+// one, so every racy access is found and no racy address is missed.
+// The race is reported with the task which stands for the dropped
+// one, so some pairs of racing tasks are not reported: a history of
+// depth N may report pairs which --exact does not.
+struct AccessSummary {
+  std::vector<SummaryWrite>  writes;
+  std::vector<AccessRecord>  reads;
+};
+
+// bytes of ring buffers allocated at once by the pool
+#define SHADOW_CHUNK_BYTES (1 << 20)
+
+// the maximum number of records kept per address
+#define SHADOW_MAX_DEPTH   UINT16_MAX
+
+class ShadowMemory {
+  private:
+    // the history of one address
+    struct Slot {
+      uint32_t  ring      : 31; // index of the ring + 1, 0 if never accessed
+      uint32_t  truncated : 1;  // records were dropped
+      uint16_t  head;           // oldest record
+      uint16_t  count;          // records in the ring
+    };
+
+    struct Page {
+      Slot      slots[SHADOW_PAGE_SLOTS];
+      uint64_t  key;  // the address of the first slot >> SHADOW_PAGE_BITS
+    };
+
+    // frees the arrays of the directory, which are calloc'ed
+    struct FreeArray {
+      VOID operator()(VOID *array) const { std::free(array); }
+    };
+
+  public:
+    // The records of an address, from the oldest to the newest
+    class History {
+      public:
+        inline size_t size() const { return slot->count; }
+
+        inline const AccessRecord &operator[](size_t i) const {
+          size_t index = slot->head + i;
+          return records[index < depth ? index : index - depth];
+        }
+
+        /** Appends a record, replacing the oldest if the ring is full */
+        inline VOID push(const AccessRecord &record) {
+          if (slot->count < depth) {
+            size_t index = slot->head + slot->count++;
+            records[index < depth ? index : index - depth] = record;
+            return;
+          }
+          records[slot->head] = record;
+          if (++slot->head == depth) slot->head = 0;
+
+          owner->dropped++;
+          if ( !slot->truncated ) {
+            slot->truncated = 1;
+            owner->truncated++;
+          }
+        }
+
+      private:
+        friend class ShadowMemory;
+
+        History(ShadowMemory *owner_, Slot *slot_,
+                AccessRecord *records_, size_t depth_)
+            : owner(owner_), slot(slot_), records(records_),
+              depth(depth_) {}
+
+        ShadowMemory  *owner;
+        Slot          *slot;
+        AccessRecord  *records;
+        size_t         depth;
+    };
+
+    /**
+     * Creates a shadow memory which keeps "depth" records per
+     * address. With a depth of 0 it only numbers the addresses.
+     */
+    explicit ShadowMemory(size_t depth_)
+        : depth(depth_), rings(0), truncated(0), dropped(0),
+          directory(static_cast<Page ***>(
+              std::calloc(SHADOW_DIRECTORY_SIZE, sizeof(Page **)))) {
+      if ( !directory ) throw std::bad_alloc();
+      chunkRings = std::max<size_t>(1, SHADOW_CHUNK_BYTES /
+                   (std::max<size_t>(1, depth) * sizeof(AccessRecord)));
+    }
+
+    /**
+     * Returns the history of "addr", creating it if absent. There
+     * are no histories with a depth of 0.
+     */
+    inline History history(ADDRESS addr) {
+      assert(depth > 0);
+      Slot &slot = slotOf(addr);
+      return History(this, &slot, ringOf(slot.ring - 1), depth);
+    }
+
+    /** Returns a number in [0, addresses()) which identifies "addr" */
+    inline size_t addressIndex(ADDRESS addr) {
+      return slotOf(addr).ring - 1;
+    }
+
+    /** Returns the number of addresses accessed */
+    inline size_t addresses() const { return rings; }
+
+    /** Returns the number of addresses whose records were dropped */
+    inline size_t truncatedHistories() const { return truncated; }
+
+    /** Returns the number of records dropped */
+    inline size_t droppedRecords() const { return dropped; }
+
+    /**
+     * Returns the bytes used by the pages and the records, and the
+     * bytes of the directory tables, even if not all touched
+     */
+    inline size_t memoryUsed() const {
+      return pages.size() * sizeof(Page) +
+             tables.size() * SHADOW_TABLE_PAGES * sizeof(Page *) +
+             chunks.size() * chunkRings * depth *
+             sizeof(AccessRecord);
+    }
+
+    /**
+     * Calls func(addr, history, truncated) for every address
+     * accessed, for saving the histories
+     */
+    template <typename FuncT>
+    VOID forEachHistory(FuncT func) {
+      assert(depth > 0);
+      for (auto &page : pages) {
+        for (size_t i = 0; i < SHADOW_PAGE_SLOTS; i++) {
+          Slot &slot = page->slots[i];
+          if ( !slot.ring ) continue;
+          uint64_t addr = (page->key << SHADOW_PAGE_BITS) | i;
+          func(reinterpret_cast<ADDRESS>(addr),
+               History(this, &slot, ringOf(slot.ring - 1), depth),
+               static_cast<BOOL>(slot.truncated));
+        }
+      }
+    }
+
+    /** Restores the records of "addr" saved, from the oldest */
+    VOID restore(ADDRESS addr, const std::vector<AccessRecord> &records,
+                 BOOL wasTruncated) {
+      assert(depth > 0);
+      Slot &slot = slotOf(addr);
+      History history(this, &slot, ringOf(slot.ring - 1), depth);
+      for (auto &record : records) history.push(record);
+      if (wasTruncated && !slot.truncated) {
+        slot.truncated = 1;
+        truncated++;
+      }
+    }
+
+    /** Adds the records dropped before a snapshot */
+    inline VOID restoreDropped(size_t records) { dropped += records; }
+
+    /** Calls func(addr, records) for every address accessed */
+    template <typename FuncT>
+    VOID forEach(FuncT func) const {
+      for (auto &page : pages) {
+        for (size_t i = 0; i < SHADOW_PAGE_SLOTS; i++) {
+          const Slot &slot = page->slots[i];
+          if ( !slot.ring ) continue;
+          uint64_t addr = (page->key << SHADOW_PAGE_BITS) | i;
+          func(reinterpret_cast<ADDRESS>(addr),
+               static_cast<size_t>(slot.count));
+        }
+      }
+    }
+
+  private:
+    inline Slot &slotOf(ADDRESS addr) {
+      uint64_t key = reinterpret_cast<uint64_t>(addr);
+      Slot &slot = pageOf(key >> SHADOW_PAGE_BITS)
+                     ->slots[key & (SHADOW_PAGE_SLOTS - 1)];
+      if ( !slot.ring ) slot.ring = newRing();
+      return slot;
+    }
+
+    // finds the page of "key" in the directory, creating it if absent
+    inline Page *pageOf(uint64_t key) {
+      uint64_t top = key >> SHADOW_TABLE_BITS;
+      if (top >= SHADOW_DIRECTORY_SIZE) {
+        Page *&page = farPages[key];
+        if ( !page ) page = newPage(key);
+        return page;
+      }
+
+      Page **&table = directory.get()[top];
+      if ( !table ) table = newTable();
+      Page *&page = table[key & (SHADOW_TABLE_PAGES - 1)];
+      if ( !page ) page = newPage(key);
+      return page;
+    }
+
+    inline Page *newPage(uint64_t key) {
+      pages.push_back( std::unique_ptr<Page>(new Page()) );
+      pages.back()->key = key;
+      return pages.back().get();
+    }
+
+    inline Page **newTable() {
+      Page **table = static_cast<Page **>(
+          std::calloc(SHADOW_TABLE_PAGES, sizeof(Page *)));
+      if ( !table ) throw std::bad_alloc();
+      tables.push_back( std::unique_ptr<Page *, FreeArray>(table) );
+      return table;
+    }
+
+    // returns the index + 1 of a fresh ring
+    inline uint32_t newRing() {
+      if (depth && rings == chunks.size() * chunkRings) {
+        chunks.push_back( std::unique_ptr<AccessRecord[]>(
+            new AccessRecord[chunkRings * depth]) );
+      }
+      return static_cast<uint32_t>(++rings);
+    }
+
+    inline AccessRecord *ringOf(size_t ring) const {
+      return chunks[ring / chunkRings].get() +
+             (ring % chunkRings) * depth;
+    }
+
+    size_t                                        depth;
+    size_t                                        chunkRings; // per chunk
+    size_t                                        rings; // allocated
+    size_t                                        truncated;
+    size_t                                        dropped;
+    std::unique_ptr<Page **, FreeArray>           directory;
+    std::vector<std::unique_ptr<Page *, FreeArray>> tables;
+    std::unordered_map<uint64_t, Page *>          farPages; // above 47 bits
+    std::vector<std::unique_ptr<Page>>            pages;
+    std::vector<std::unique_ptr<AccessRecord[]>>  chunks;
+};
+
+#endif // end shadowMemory.hpp
@@ -0,0 +1,224 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements the k-way merge of the Tracelog shards.
+
+#include "shardedTrace.hpp"
+#include <cstring>
+#include <functional>
+#include <queue>
+
+// true for a text line "sequence Q", without the '\n'
+static inline BOOL isSequenceLine(const char *pos, const char *eol,
+                                  uint64_t &sequence) {
+  const char *first = pos;
+  sequence = 0;
+  while (pos < eol && *pos >= '0' && *pos <= '9') {
+    sequence = sequence * 10 + (*pos - '0');
+    pos++;
+  }
+  if (pos == first || eol - pos < 2 || pos[0] != ' ' || pos[1] != 'Q') {
+    return false;
+  }
+  pos += 2;
+  return pos == eol || (*pos == '\r' && pos + 1 == eol);
+}
+
+BOOL ShardedTraceReader::isManifest(const char *logName) {
+  FILE *log = fopen(logName, "rb");
+  if ( !log ) return false;
+
+  char magic[sizeof(TRACE_MANIFEST_MAGIC) - 1];
+  size_t count = fread(magic, sizeof(magic), 1, log);
+  fclose(log);
+
+  return count == 1 &&
+         memcmp(magic, TRACE_MANIFEST_MAGIC, sizeof(magic)) == 0;
+}
+
+BOOL ShardedTraceReader::readManifest(const char *logName,
+                               std::vector<std::string> &shardNames) {
+  MappedFile manifest;
+  if ( !manifest.open(logName) ) return false;
+
+  // the shards are next to the manifest
+  std::string directory(logName);
+  size_t slash = directory.rfind('/');
+  directory = (slash == std::string::npos) ? ""
+                                           : directory.substr(0, slash + 1);
+
+  const char *pos = manifest.begin();
+  const char *end = manifest.end();
+  BOOL header = true;
+  while (pos < end) {
+    const char *eol = static_cast<const char *>(
+        memchr(pos, '\n', end - pos));
+    if ( !eol ) eol = end;
+
+    std::string line(pos, eol);
+    pos = eol + 1;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+
+    if ( header ) { // the magic line
+      header = false;
+      if (line != TRACE_MANIFEST_MAGIC) return false;
+    } else if ( !line.empty() ) {
+      shardNames.push_back(line[0] == '/' ? line : directory + line);
+    }
+  }
+  return !header;
+}
+
+BOOL ShardedTraceReader::readHBlog(const char *logName,
+                                   Checker &checker) {
+  std::vector<std::string> shardNames;
+  if ( !readManifest(logName, shardNames) ) return false;
+
+  // the edges are independent of each other, no merge
+  for (const auto &shardName : shardNames) {
+    BOOL read = BinaryTraceReader::isBinaryLog(shardName.c_str()) ?
+        binary.readHBlog(shardName.c_str(), checker) :
+        text.readHBlog(shardName.c_str(), checker);
+    if ( !read ) {
+      std::cout << "Shard: " << shardName << " could not be read."
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+BOOL ShardedTraceReader::readTrace(const char *logName,
+                                   Checker &checker) {
+  std::vector<std::string> shardNames;
+  if ( !readManifest(logName, shardNames) ) return false;
+
+  // the snapshots hold an offset in a single trace
+  MappedFile manifest;
+  size_t offset;
+  if (!manifest.open(logName) ||
+      !checker.resumeOffset(manifest.begin(), manifest.size(), offset)) {
+    return false;
+  }
+  if ( offset ) {
+    std::cout << "Snapshot: sharded traces can not be resumed."
+              << std::endl;
+    return false;
+  }
+
+  std::vector< std::unique_ptr<Shard> > shards;
+  for (const auto &shardName : shardNames) {
+    std::unique_ptr<Shard> shard(new Shard());
+    if ( !shard->log.open(shardName.c_str()) ) {
+      std::cout << "Shard: " << shardName << " could not be read."
+                << std::endl;
+      return false;
+    }
+
+    const char *begin = shard->log.begin();
+    shard->binary = shard->log.size() >= sizeof(TraceFormat::FileHeader) &&
+        memcmp(begin, TraceFormat::MAGIC, sizeof(TraceFormat::MAGIC)) == 0;
+    if (shard->binary &&
+        !TraceFormat::isValidHeader(
+            *reinterpret_cast<const TraceFormat::FileHeader *>(begin))) {
+      std::cout << "Unsupported binary log: " << shardName << std::endl;
+      return false;
+    }
+    shard->pos = shard->binary ? begin + sizeof(TraceFormat::FileHeader)
+                               : begin;
+    shards.push_back( std::move(shard) );
+  }
+
+  // the events before the first block of a shard (functions
+  // registered) come first, then the blocks by sequence number
+  typedef std::pair<uint64_t, size_t> NextBlock;
+  std::priority_queue<NextBlock, std::vector<NextBlock>,
+                      std::greater<NextBlock> > blocks;
+
+  for (size_t i = 0; i < shards.size(); i++) {
+    Shard &shard = *shards[i];
+    const char *next;
+    const char *first = findSequence(shard, next, shard.sequence);
+    if ( !processEvents(shard, shard.pos, first, checker) ) return false;
+    shard.pos = next;
+    if (first != shard.log.end()) {
+      blocks.push( NextBlock(shard.sequence, i) );
+    }
+  }
+
+  while ( !blocks.empty() ) {
+    size_t index = blocks.top().second;
+    Shard &shard = *shards[index];
+    blocks.pop();
+
+    const char *next;
+    uint64_t sequence;
+    const char *last = findSequence(shard, next, sequence);
+    if ( !processEvents(shard, shard.pos, last, checker) ) return false;
+
+    shard.pos = next;
+    if (last != shard.log.end()) {
+      shard.sequence = sequence;
+      blocks.push( NextBlock(sequence, index) );
+    }
+  }
+  return true;
+}
+
+const char *ShardedTraceReader::findSequence(Shard &shard,
+                                             const char *&next,
+                                             uint64_t &sequence) {
+  const char *pos = shard.pos;
+  const char *end = shard.log.end();
+
+  if ( shard.binary ) {
+    while (static_cast<size_t>(end - pos) >= sizeof(TraceFormat::Record)) {
+      const TraceFormat::Record *rec =
+          reinterpret_cast<const TraceFormat::Record *>(pos);
+      size_t size = sizeof(TraceFormat::Record) +
+                    TraceFormat::paddedSize(rec->payloadSize);
+      if (static_cast<size_t>(end - pos) < size) break; // not complete
+
+      if (rec->type == TraceFormat::SEQUENCE) {
+        next     = pos + size;
+        sequence = static_cast<uint64_t>(rec->value);
+        return pos;
+      }
+      pos += size;
+    }
+  } else {
+    while (pos < end) {
+      const char *eol = static_cast<const char *>(
+          memchr(pos, '\n', end - pos));
+      if ( !eol ) eol = end;
+
+      if ( isSequenceLine(pos, eol, sequence) ) {
+        next = std::min(eol + 1, end);
+        return pos;
+      }
+      pos = std::min(eol + 1, end);
+    }
+  }
+
+  next = end;
+  return end;
+}
+
+BOOL ShardedTraceReader::processEvents(Shard &shard, const char *pos,
+                                       const char *end,
+                                       Checker &checker) {
+  if ( !shard.binary ) return text.processLines(pos, end, checker);
+
+  // a shard of a crashed program may end in a partial record
+  binary.processRecords(pos, end, checker);
+  return true;
+}
@@ -0,0 +1,66 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the reader of the logs written by a thread each
+// (DFINSPEC_TRACE_SHARDS=1). The Tracelog and HBlog given are
+// manifests listing the shards. The task blocks of the Tracelog
+// shards are merged by their sequence numbers, so the checker sees
+// the tasks in the order they ended, as in a single Tracelog. The
+// shards may be text or binary; no snapshot is taken of them.
+
+#ifndef _DETECTOR_SHARDEDTRACE_HPP_
+#define _DETECTOR_SHARDEDTRACE_HPP_
+
+#include "checker.hpp"
+#include "binaryTrace.hpp"
+#include "textTrace.hpp"
+#include "mappedFile.hpp"
+#include <memory>
+
+class ShardedTraceReader {
+  public:
+    /** Returns true if the log file is a manifest of shards */
+    static BOOL isManifest(const char *logName);
+
+    /** Reads the happens-before edges of every HBlog shard */
+    BOOL readHBlog(const char *logName, Checker &checker);
+
+    /** Merges the task blocks of the Tracelog shards */
+    BOOL readTrace(const char *logName, Checker &checker);
+
+  private:
+    typedef struct Shard {
+      MappedFile   log;
+      BOOL         binary;
+      const char  *pos;      // the next block, after its sequence event
+      uint64_t     sequence; // of the next block
+    } Shard;
+
+    // the file names listed by a manifest
+    BOOL readManifest(const char *logName,
+                      std::vector<std::string> &shardNames);
+
+    // finds the next sequence event of "shard" from its position,
+    // returns where it starts (or the end of the shard) and sets
+    // "next" past it
+    const char *findSequence(Shard &shard, const char *&next,
+                             uint64_t &sequence);
+
+    // checks the events in [pos, end) of a shard
+    BOOL processEvents(Shard &shard, const char *pos, const char *end,
+                       Checker &checker);
+
+    TextTraceReader    text;
+    BinaryTraceReader  binary;
+};
+
+#endif // end shardedTrace.hpp
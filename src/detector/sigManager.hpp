@@ -17,26 +17,30 @@
 
 #include <unordered_map>
 #include <cassert>
+#include "nameInterner.hpp"
 
 class SigManager {
 
 private:
-  std::unordered_map<INTEGER, std::string> functions;
+  NameInterner                         &names;
+  std::unordered_map<INTEGER, INTEGER>  functions; // interned names
 
 public:
+  explicit SigManager(NameInterner &names_): names(names_) {}
+
   /**
    * Stores function "name" with id "id"
    */
-  void addFuncName(std::string name, INTEGER id) {
+  void addFuncName(const std::string &name, INTEGER id) {
 
     assert(functions.find(id) == functions.end());
-    functions[id] = name;
+    functions[id] = names.intern(name);
   }
 
   /**
    * Returns the function signature given the function id
    */
-  std::string getFuncName(INTEGER id) {
+  const std::string &getFuncName(INTEGER id) const {
 
     auto fIdptr = functions.find( id );
     if ( fIdptr == functions.end() ) {
@@ -44,21 +48,45 @@ public:
                 << id << std::endl;
     }
     assert(fIdptr != functions.end());
-    return fIdptr->second;
+    return names.name(fIdptr->second);
   }
 
   /**
    * Returns the function name identifier
    */
-  INTEGER getFuncId(std::string name) {
+  INTEGER getFuncId(const std::string &name) const {
+    INTEGER nameId = names.find(name);
     for (const auto& func : functions) {
-       if (func.second == name) {
+       if (func.second == nameId) {
          return func.first;
        }
      }
     return 0; // FIXME
   }
 
+  /**
+   * Writes the function ids and their interned names
+   */
+  void save(SnapshotWriter &out) const {
+    out.write<uint64_t>(functions.size());
+    for (const auto &func : functions) {
+      out.write<int64_t>(func.first);
+      out.write<int64_t>(func.second);
+    }
+  }
+
+  /**
+   * Reads the functions saved, after the names
+   */
+  bool load(SnapshotReader &in) {
+    uint64_t count = in.read<uint64_t>();
+    for (uint64_t i = 0; i < count && in.good(); i++) {
+      INTEGER id = in.read<int64_t>();
+      functions[id] = in.read<int64_t>();
+    }
+    return in.good();
+  }
+
 }; // end class
 
 #endif // SigManager_HPP_
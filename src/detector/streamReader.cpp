@@ -0,0 +1,188 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements the reader of streamed events.
+
+#include "streamReader.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// the prefix of local socket stream names, as in TraceOutput.hpp
+#define STREAM_SOCKET_PREFIX "unix:"
+
+int StreamReader::openStream(const char *streamName) {
+  size_t prefixLen = strlen(STREAM_SOCKET_PREFIX);
+  if (strncmp(streamName, STREAM_SOCKET_PREFIX, prefixLen) != 0) {
+    // a FIFO, the program opens it for writing
+    if (mkfifo(streamName, 0600) != 0 && errno != EEXIST) return -1;
+    return ::open(streamName, O_RDONLY);
+  }
+
+  const char *path = streamName + prefixLen;
+  struct sockaddr_un address;
+  if (strlen(path) >= sizeof(address.sun_path)) return -1;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+  unlink(path); // left by an earlier run
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) return -1;
+
+  int connection = -1;
+  if (bind(listener, reinterpret_cast<struct sockaddr *>(&address),
+           sizeof(address)) == 0 && listen(listener, 1) == 0) {
+    std::cout << "Waiting for the program on " << path << std::endl;
+    connection = accept(listener, NULL, NULL);
+  }
+  ::close(listener);
+  unlink(path);
+  return connection;
+}
+
+BOOL StreamReader::read(const char *streamName, Checker &checker) {
+  size_t ringPrefixLen = strlen(TRACE_RING_PREFIX);
+  if (strncmp(streamName, TRACE_RING_PREFIX, ringPrefixLen) == 0) {
+    return readRing(streamName + ringPrefixLen, checker);
+  }
+
+  int fd = openStream(streamName);
+  if (fd < 0) return false;
+
+  buffer.resize(STREAM_READ_SIZE);
+  used = 0;
+
+  BOOL ok = true;
+  while ( ok ) {
+    if (buffer.size() - used < STREAM_READ_SIZE / 2) {
+      buffer.resize(buffer.size() * 2); // a long event
+    }
+
+    ssize_t count = ::read(fd, buffer.data() + used, buffer.size() - used);
+    if (count < 0 && errno == EINTR) continue;
+    if (count <= 0) break; // the program finished
+
+    used += count;
+    ok = processBuffer(checker, false);
+  }
+  ::close(fd);
+
+  return ok && processBuffer(checker, true);
+}
+
+BOOL StreamReader::readRing(const char *path, Checker &checker) {
+  SharedRing ring;
+  BOOL waiting = false;
+  while ( !ring.open(path) ) {
+    if (access(path, F_OK) == 0) { // not a ring of this version
+      std::cout << "Unsupported ring " << path << std::endl;
+      return false;
+    }
+    if ( !waiting ) { // the program creates the ring
+      std::cout << "Waiting for the program on " << path << std::endl;
+      waiting = true;
+    }
+    TraceRing::waitABit();
+  }
+
+  // the events are read in place and freed once they are checked
+  uint64_t pos = ring.consumed();
+  while (true) {
+    // whatever was committed before the program ended is read next
+    BOOL done = ring.writerDone();
+    uint64_t last = ring.committed();
+
+    size_t consumed = 0;
+    if (last != pos) {
+      if ( !processEvents(ring.at(pos), last - pos, checker, false,
+                          consumed) ) {
+        return false;
+      }
+      pos += consumed;
+      ring.consume(pos);
+    }
+    if ( consumed ) continue;
+    if ( done ) break;
+    TraceRing::waitABit();
+  }
+
+  // a last event without its end, e.g. of a program which died
+  uint64_t last = ring.committed();
+  size_t consumed;
+  if ( !processEvents(ring.at(pos), last - pos, checker, true,
+                      consumed) ) {
+    return false;
+  }
+  ring.consume(last);
+  return true;
+}
+
+BOOL StreamReader::processBuffer(Checker &checker, BOOL atEnd) {
+  size_t consumed;
+  if ( !processEvents(buffer.data(), used, checker, atEnd, consumed) ) {
+    return false;
+  }
+
+  used -= consumed;
+  memmove(buffer.data(), buffer.data() + consumed, used);
+  return true;
+}
+
+BOOL StreamReader::processEvents(const char *begin, size_t size,
+                                 Checker &checker, BOOL atEnd,
+                                 size_t &consumed) {
+  consumed = 0;
+  if (format < 0) { // binary streams start with the file header
+    if (size < sizeof(TraceFormat::FileHeader)) {
+      if ( !atEnd ) return true;
+      format = 0;
+    } else {
+      const TraceFormat::FileHeader *header =
+          reinterpret_cast<const TraceFormat::FileHeader *>(begin);
+      if (memcmp(header->magic, TraceFormat::MAGIC,
+                 sizeof(TraceFormat::MAGIC)) != 0) {
+        format = 0;
+      } else if ( !TraceFormat::isValidHeader(*header) ) {
+        std::cout << "Unsupported binary stream" << std::endl;
+        return false;
+      } else {
+        format    = 1;
+        consumed  = sizeof(TraceFormat::FileHeader);
+        begin    += consumed;
+        size     -= consumed;
+      }
+    }
+  }
+
+  size_t processed;
+  if (format == 1) {
+    processed = binaryReader.processRecords(begin, begin + size, checker);
+    if (atEnd && processed != size) {
+      std::cout << "Warning: truncated binary stream" << std::endl;
+    }
+  } else {
+    // complete lines only, a last line without '\n' at the end
+    const char *last = static_cast<const char *>(
+        memrchr(begin, '\n', size));
+    processed = atEnd ? size : (last ? last - begin + 1 : 0);
+    if ( !textReader.processLines(begin, begin + processed, checker) ) {
+      return false;
+    }
+  }
+
+  consumed += processed;
+  return true;
+}
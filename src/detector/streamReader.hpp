@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the reader of the events streamed by a running program
+// (DFINSPEC_STREAM). The stream is a FIFO, created if missing, a
+// local socket "unix:path" which the reader listens on, or a ring
+// "ring:path" in a file mapped by both (traceRing.hpp). Text lines
+// and binary records are passed to the text and binary readers as
+// soon as they are complete; the events of a ring are read in
+// place.
+
+#ifndef _DETECTOR_STREAMREADER_HPP_
+#define _DETECTOR_STREAMREADER_HPP_
+
+#include "checker.hpp"
+#include "binaryTrace.hpp"
+#include "textTrace.hpp"
+#include "traceRing.hpp"
+
+// bytes read from the stream at once
+#define STREAM_READ_SIZE (1 << 20)
+
+class StreamReader {
+  public:
+    /** Checks the events of "streamName" until the program ends */
+    BOOL read(const char *streamName, Checker &checker);
+
+  private:
+    // opens the FIFO or accepts the connection of the program
+    int openStream(const char *streamName);
+
+    // checks the events of the ring file "path" until the program
+    // finishes or dies, then the events left in the ring
+    BOOL readRing(const char *path, Checker &checker);
+
+    // processes the complete events in the buffer and keeps the
+    // rest, returns false on error
+    BOOL processBuffer(Checker &checker, BOOL atEnd);
+
+    // processes the complete events in [begin, begin + size) and
+    // sets "consumed" to their bytes, returns false on error
+    BOOL processEvents(const char *begin, size_t size, Checker &checker,
+                       BOOL atEnd, size_t &consumed);
+
+    std::vector<char>  buffer;
+    size_t             used   = 0;     // bytes in the buffer
+    int                format = -1;    // -1 unknown, 0 text, 1 binary
+    TextTraceReader    textReader;
+    BinaryTraceReader  binaryReader;
+};
+
+#endif // end streamReader.hpp
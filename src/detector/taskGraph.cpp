@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements the compressed sparse row task graph.
+
+#include "taskGraph.hpp"
+
+VOID TaskGraph::finalize() {
+  if ( staged.empty() ) return;
+
+  // merge the new edges, an edge may be logged more than once
+  edges.insert(edges.end(), staged.begin(), staged.end());
+  std::vector<std::pair<int, int>>().swap(staged);
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  buildRows(edges, known.size(), outOffsets, outTargets);
+
+  std::vector<std::pair<int, int>> reversed;
+  reversed.reserve(edges.size());
+  for (auto &edge : edges) {
+    reversed.push_back( std::make_pair(edge.second, edge.first) );
+  }
+  std::sort(reversed.begin(), reversed.end());
+  buildRows(reversed, known.size(), inOffsets, inTargets);
+}
+
+VOID TaskGraph::buildRows(const std::vector<std::pair<int, int>> &edges,
+                          size_t rows, std::vector<int> &offsets,
+                          std::vector<int> &targets) {
+  offsets.assign(rows + 1, 0);
+  targets.resize(edges.size());
+
+  for (size_t i = 0; i < edges.size(); i++) {
+    offsets[edges[i].first + 1]++;
+    targets[i] = edges[i].second;
+  }
+  for (size_t row = 0; row < rows; row++) {
+    offsets[row + 1] += offsets[row];
+  }
+}
+
+VOID TaskGraph::save(SnapshotWriter &out) {
+  finalize();
+
+  out.write<uint64_t>(tasks);
+  for (size_t taskID = 0; taskID < known.size(); taskID++) {
+    if ( !known[taskID] ) continue;
+    out.write<int64_t>(taskID);
+    out.write<int64_t>(names[taskID]);
+  }
+  out.writeVector(edges);
+}
+
+BOOL TaskGraph::load(SnapshotReader &in) {
+  uint64_t count = in.read<uint64_t>();
+  for (uint64_t i = 0; i < count && in.good(); i++) {
+    INTEGER taskID = in.read<int64_t>();
+    INTEGER nameID = in.read<int64_t>();
+    if (taskID < 0) return false;
+    setName(taskID, nameID);
+  }
+
+  std::vector<std::pair<int, int>> saved;
+  in.readVector(saved);
+  for (auto &edge : saved) { // (parent, child)
+    if (edge.first < 0 || edge.second < 0) return false;
+    addEdge(edge.second, edge.first);
+  }
+  return in.good();
+}
@@ -0,0 +1,138 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the happens-before graph of the tasks. The runtime
+// numbers the tasks densely from 0, so the tasks are indexed by
+// their ids. The edges are collected first and then stored in
+// compressed sparse row form: the parents, respectively the
+// children, of all tasks in one array, each task owning the range
+// between its offset and the offset of the next task.
+
+#ifndef _DETECTOR_TASKGRAPH_HPP_
+#define _DETECTOR_TASKGRAPH_HPP_
+
+#include "defs.hpp"
+#include "checkpoint.hpp"
+
+class TaskGraph {
+  public:
+    // the ids of the parents or the children of a task
+    class Range {
+      public:
+        Range(const int *first_, const int *last_)
+            : first(first_), last(last_) {}
+
+        inline const int *begin() const { return first; }
+        inline const int *end()   const { return last; }
+        inline size_t     size()  const { return last - first; }
+
+      private:
+        const int *first;
+        const int *last;
+    };
+
+    TaskGraph(): tasks(0) {}
+
+    /** Adds the edge parent --> child */
+    inline VOID addEdge(INTEGER child, INTEGER parent) {
+      addTask(child);
+      addTask(parent);
+      staged.push_back( std::make_pair(static_cast<int>(parent),
+                                       static_cast<int>(child)) );
+    }
+
+    /** Adds a task without edges */
+    inline VOID addTask(INTEGER taskID) {
+      if (taskID >= static_cast<INTEGER>(known.size())) {
+        size_t size = std::max<size_t>(taskID + 1, known.size() * 2);
+        known.resize(size, false);
+        names.resize(size, -1);
+      }
+      if ( !known[taskID] ) {
+        known[taskID] = true;
+        tasks++;
+      }
+    }
+
+    /** Sets the interned name of a task */
+    inline VOID setName(INTEGER taskID, INTEGER nameID) {
+      addTask(taskID);
+      names[taskID] = nameID;
+    }
+
+    /** Returns the interned name of a task, -1 if not known */
+    inline INTEGER name(INTEGER taskID) const {
+      return contains(taskID) ? names[taskID] : -1;
+    }
+
+    inline BOOL contains(INTEGER taskID) const {
+      return taskID >= 0 &&
+             taskID < static_cast<INTEGER>(known.size()) && known[taskID];
+    }
+
+    /** Returns the number of tasks */
+    inline size_t size() const { return tasks; }
+
+    /** Returns a bound on the task ids, for iterating over them */
+    inline size_t idBound() const { return known.size(); }
+
+    // The edges added since the last call are stored first
+    inline Range parents(INTEGER taskID) {
+      if ( !staged.empty() ) finalize();
+      return rangeOf(inOffsets, inTargets, taskID);
+    }
+
+    inline Range children(INTEGER taskID) {
+      if ( !staged.empty() ) finalize();
+      return rangeOf(outOffsets, outTargets, taskID);
+    }
+
+    /** Stores the edges added in compressed sparse row form */
+    VOID finalize();
+
+    /** Writes the tasks, their names and the edges */
+    VOID save(SnapshotWriter &out);
+
+    /** Adds the tasks and the edges saved */
+    BOOL load(SnapshotReader &in);
+
+  private:
+    static inline Range rangeOf(const std::vector<int> &offsets,
+                                const std::vector<int> &targets,
+                                INTEGER taskID) {
+      if (taskID < 0 ||
+          taskID + 1 >= static_cast<INTEGER>(offsets.size())) {
+        return Range(NULL, NULL);
+      }
+      const int *base = targets.data();
+      return Range(base + offsets[taskID], base + offsets[taskID + 1]);
+    }
+
+    // builds the rows of "edges" sorted by (source, target)
+    static VOID buildRows(const std::vector<std::pair<int, int>> &edges,
+                          size_t rows, std::vector<int> &offsets,
+                          std::vector<int> &targets);
+
+    std::vector<bool>                 known; // per task id
+    std::vector<INTEGER>              names; // interned
+    size_t                            tasks; // known
+
+    std::vector<std::pair<int, int>>  staged; // (parent, child)
+    std::vector<std::pair<int, int>>  edges;  // stored, unique
+
+    std::vector<int>                  inOffsets;  // parents
+    std::vector<int>                  inTargets;
+    std::vector<int>                  outOffsets; // children
+    std::vector<int>                  outTargets;
+};
+
+#endif // end taskGraph.hpp
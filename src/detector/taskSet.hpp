@@ -0,0 +1,206 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the sets of task ids kept in the serial bags.
+//
+//   HashTaskSet: the original hash set of task ids.
+//   TaskSet:     a sorted vector of ids while the set is small, and
+//                a bitset over the dense task ids once the bitset
+//                is not larger than the vector. A bitset which a
+//                large id made twice as large as the vector goes
+//                back to a vector. Bitsets are merged with a
+//                vectorized OR and counted with popcount.
+
+#ifndef _DETECTOR_TASKSET_HPP_
+#define _DETECTOR_TASKSET_HPP_
+
+#include "defs.hpp"
+#include <cstdint>
+#include <iterator>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+class HashTaskSet {
+  public:
+    inline VOID insert(int taskID) { tasks.insert(taskID); }
+
+    inline VOID insertAll(const HashTaskSet &other) {
+      tasks.insert(other.tasks.begin(), other.tasks.end());
+    }
+
+    inline BOOL contains(int taskID) const {
+      return tasks.find(taskID) != tasks.end();
+    }
+
+    inline size_t size() const { return tasks.size(); }
+
+    template <typename FuncT>
+    VOID forEach(FuncT func) const {
+      for (auto taskID : tasks) func(taskID);
+    }
+
+  private:
+    UNORD_INTSET tasks;
+};
+
+
+// sets with more elements than this may become bitsets
+#define TASKSET_DENSE_MIN 64
+
+class TaskSet {
+  public:
+    TaskSet(): count(0), dense(false) {}
+
+    inline VOID insert(int taskID) {
+      if ( dense ) {
+        setBit(taskID);
+        sparsifyIfLarger();
+        return;
+      }
+
+      auto pos = std::lower_bound(ids.begin(), ids.end(), taskID);
+      if (pos != ids.end() && *pos == taskID) return;
+      ids.insert(pos, taskID);
+      count++;
+      densifyIfSmaller();
+    }
+
+    VOID insertAll(const TaskSet &other) {
+      if ( !other.count ) return;
+
+      if ( !dense && !other.dense ) { // merge the sorted vectors
+        INTVECTOR merged;
+        merged.reserve(ids.size() + other.ids.size());
+        std::set_union(ids.begin(), ids.end(),
+                       other.ids.begin(), other.ids.end(),
+                       std::back_inserter(merged));
+        ids.swap(merged);
+        count = ids.size();
+        densifyIfSmaller();
+        return;
+      }
+
+      if ( !dense ) toDense(); // the result is at least as dense
+
+      if ( !other.dense ) {
+        for (auto taskID : other.ids) setBit(taskID);
+      } else {
+        if (words.size() < other.words.size()) {
+          words.resize(other.words.size(), 0);
+        }
+        orWords(words.data(), other.words.data(), other.words.size());
+        count = countBits();
+      }
+      sparsifyIfLarger();
+    }
+
+    inline BOOL contains(int taskID) const {
+      if ( dense ) {
+        size_t word = static_cast<size_t>(taskID) >> 6;
+        return word < words.size() &&
+               ((words[word] >> (taskID & 63)) & 1);
+      }
+      return std::binary_search(ids.begin(), ids.end(), taskID);
+    }
+
+    inline size_t size() const { return count; }
+
+    inline BOOL isDense() const { return dense; }
+
+    /** Returns the bytes used by the elements of the set */
+    inline size_t memoryUsed() const {
+      return dense ? words.size() * sizeof(uint64_t)
+                   : ids.size() * sizeof(int);
+    }
+
+    template <typename FuncT>
+    VOID forEach(FuncT func) const {
+      if ( !dense ) {
+        for (auto taskID : ids) func(taskID);
+        return;
+      }
+      for (size_t i = 0; i < words.size(); i++) {
+        for (uint64_t word = words[i]; word; word &= word - 1) {
+          func(static_cast<int>(i * 64 + __builtin_ctzll(word)));
+        }
+      }
+    }
+
+  private:
+    inline VOID setBit(int taskID) {
+      size_t word = static_cast<size_t>(taskID) >> 6;
+      if (word >= words.size()) words.resize(word + 1, 0);
+
+      uint64_t bit = 1ULL << (taskID & 63);
+      count += !(words[word] & bit);
+      words[word] |= bit;
+    }
+
+    // a bitset over [0, largest id] against 32 bits per element
+    inline VOID densifyIfSmaller() {
+      if (count > TASKSET_DENSE_MIN &&
+          static_cast<size_t>(ids.back()) + 1 <= count * 32) {
+        toDense();
+      }
+    }
+
+    // more words than elements: the bitset is over twice as large
+    // as the vector, which would not become a bitset again soon
+    inline VOID sparsifyIfLarger() {
+      if (words.size() > count) toSparse();
+    }
+
+    VOID toDense() {
+      dense = true;
+      count = 0;
+      for (auto taskID : ids) setBit(taskID);
+      INTVECTOR().swap(ids);
+    }
+
+    VOID toSparse() {
+      ids.reserve(count);
+      forEach([this](int taskID) { ids.push_back(taskID); });
+      dense = false;
+      std::vector<uint64_t>().swap(words);
+    }
+
+    // dst |= src over "size" words
+    static inline VOID orWords(uint64_t *dst, const uint64_t *src,
+                               size_t size) {
+      size_t i = 0;
+#ifdef __SSE2__
+      for (; i + 2 <= size; i += 2) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i *>(dst + i));
+        __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_or_si128(a, b));
+      }
+#endif
+      for (; i < size; i++) dst[i] |= src[i];
+    }
+
+    inline size_t countBits() const {
+      size_t bits = 0;
+      for (auto word : words) bits += __builtin_popcountll(word);
+      return bits;
+    }
+
+    size_t                 count;  // elements in the set
+    bool                   dense;
+    INTVECTOR              ids;    // sorted, if not dense
+    std::vector<uint64_t>  words;  // bits, if dense
+};
+
+#endif // end taskSet.hpp
@@ -0,0 +1,218 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Implements the reader of the text Tracelog and HBlog files.
+
+#include "textTrace.hpp"
+#include <cstring>
+
+// Helper scanners, they advance "pos" past what they read
+
+static inline VOID skipSpaces(const char *&pos, const char *end) {
+  while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+    pos++;
+  }
+}
+
+static inline BOOL scanDecimal(const char *&pos, const char *end,
+                               INTEGER &number) {
+  skipSpaces(pos, end);
+  bool negative = false;
+  if (pos < end && (*pos == '-' || *pos == '+')) {
+    negative = (*pos == '-');
+    pos++;
+  }
+
+  const char *first = pos;
+  unsigned long value = 0;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    value = value * 10 + (*pos - '0');
+    pos++;
+  }
+  number = negative ? -static_cast<INTEGER>(value)
+                    : static_cast<INTEGER>(value);
+  return pos != first;
+}
+
+static inline BOOL scanHex(const char *&pos, const char *end,
+                           unsigned long &number) {
+  skipSpaces(pos, end);
+  if (end - pos > 1 && pos[0] == '0' && (pos[1] == 'x' || pos[1] == 'X')) {
+    pos += 2;
+  }
+
+  const char *first = pos;
+  number = 0;
+  for (; pos < end; pos++) {
+    char c = *pos;
+    if (c >= '0' && c <= '9')      number = (number << 4) | (c - '0');
+    else if (c >= 'a' && c <= 'f') number = (number << 4) | (c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F') number = (number << 4) | (c - 'A' + 10);
+    else break;
+  }
+  return pos != first;
+}
+
+static inline VOID scanToken(const char *&pos, const char *end,
+                             const char *&token, size_t &length) {
+  skipSpaces(pos, end);
+  token = pos;
+  while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r') {
+    pos++;
+  }
+  length = pos - token;
+}
+
+static inline BOOL isToken(const char *token, size_t length,
+                           const char *expected) {
+  return strlen(expected) == length &&
+         memcmp(token, expected, length) == 0;
+}
+
+BOOL TextTraceReader::readHBlog(const char *logName, Checker &checker) {
+  MappedFile log;
+  if ( !log.open(logName) ) return false;
+
+  const char *pos = log.begin();
+  const char *end = log.end();
+  while (pos < end) {
+    const char *eol = static_cast<const char *>(
+        memchr(pos, '\n', end - pos));
+    if ( !eol ) eol = end;
+
+    INTEGER sibId;
+    INTEGER parId;
+    if (scanDecimal(pos, eol, sibId) && scanDecimal(pos, eol, parId)) {
+      checker.addTaskEdge(sibId, parId);
+    }
+    pos = eol + 1;
+  }
+  return true;
+}
+
+BOOL TextTraceReader::readTrace(const char *logName, Checker &checker) {
+  MappedFile log;
+  if ( !log.open(logName) ) return false;
+
+  size_t offset;
+  if ( !checker.resumeOffset(log.begin(), log.size(), offset) ) {
+    return false;
+  }
+  return processLines(log.begin() + offset, log.end(), checker,
+                      log.begin());
+}
+
+BOOL TextTraceReader::processLines(const char *pos, const char *end,
+                                   Checker &checker, const char *trace) {
+  while (pos < end) {
+    const char *eol = static_cast<const char *>(
+        memchr(pos, '\n', end - pos));
+    if ( !eol ) eol = end;
+
+    if ( !processLine(pos, eol, checker) ) return false;
+    pos = eol + 1;
+
+    if (trace && checker.checkpointDue() && pos <= end) {
+      checker.saveCheckpoint(trace, pos - trace);
+    }
+  }
+  return true;
+}
+
+BOOL TextTraceReader::scanAction(const char *&pos, const char *end,
+                                 BOOL isWrite, Action &action) {
+  unsigned long addr;
+  if ( !scanHex(pos, end, addr) ) return false;
+  action.addr = reinterpret_cast<ADDRESS>(addr);
+
+  INTEGER funcId;
+  if ( !scanDecimal(pos, end, action.value)  ||
+       !scanDecimal(pos, end, action.lineNo) ||
+       !scanDecimal(pos, end, funcId) ) {
+    return false;
+  }
+  action.funcId  = funcId;
+  action.isWrite = isWrite;
+  return true;
+}
+
+BOOL TextTraceReader::processLine(const char *pos, const char *end,
+                                  Checker &checker) {
+  const char *line = pos;
+
+  INTEGER taskID;
+  if ( !scanDecimal(pos, end, taskID) ) return true; // empty line
+
+  const char *oper;
+  size_t      operLen;
+  scanToken(pos, end, oper, operLen);
+
+  if (operLen == 1 && (*oper == 'W' || *oper == 'R')) {
+    Action action;
+    action.taskId = taskID;
+    if ( !scanAction(pos, end, *oper == 'W', action) ) {
+      std::cout << "Malformed trace line: "
+                << std::string(line, end) << std::endl;
+      return false;
+    }
+
+    if (action.funcId == 0) {
+      std::cout << "Warning function Id 0: "
+                << std::string(line, end) << std::endl;
+      exit(0);
+    }
+
+    MemoryActions memActions( action ); // save first action
+
+    // there are still tokens: "| taskID oper action"
+    const char *separator;
+    size_t      separatorLen;
+    scanToken(pos, end, separator, separatorLen);
+    if ( separatorLen ) {
+      Action lastWAction;
+      if ( scanDecimal(pos, end, taskID) ) {
+        lastWAction.taskId = taskID;
+        scanToken(pos, end, oper, operLen);
+        if (operLen && scanAction(pos, end, *oper == 'W', lastWAction)) {
+          memActions.storeAction( lastWAction ); // save second action
+        }
+      }
+    }
+
+    checker.saveTaskActions( memActions ); // save the actions
+  } else if (isToken(oper, operLen, "F")) {
+    // task id position is func ID in this case
+    skipSpaces(pos, end);
+    name.assign(pos, end);
+    checker.registerFunction(taskID, name);
+  } else if (isToken(oper, operLen, "B")) {
+    // new task creation, parents terminated
+    const char *taskName;
+    size_t      taskNameLen;
+    scanToken(pos, end, taskName, taskNameLen);
+    name.assign(taskName, taskNameLen);
+    checker.beginTask(taskID, name);
+  } else if (isToken(oper, operLen, "C")) {
+    // token received: "taskID C taskName parentID"
+    const char *taskName;
+    size_t      taskNameLen;
+    scanToken(pos, end, taskName, taskNameLen);
+    INTEGER parentID;
+    if ( scanDecimal(pos, end, parentID) ) {
+      checker.receiveToken(taskID, parentID);
+    }
+  } else if (isToken(oper, operLen, "E")) {
+    checker.endTask();
+  }
+  // S, BTM and ETM events are not used for checking
+  return true;
+}
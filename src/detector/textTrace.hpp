@@ -0,0 +1,53 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the reader of the text Tracelog and HBlog files.
+// The files are memory mapped and tokenized in place; numbers
+// are scanned directly from the mapping and the events are
+// passed to the checker through its typed events.
+
+#ifndef _DETECTOR_TEXTTRACE_HPP_
+#define _DETECTOR_TEXTTRACE_HPP_
+
+#include "checker.hpp"
+#include "mappedFile.hpp"
+
+class TextTraceReader {
+  public:
+    /** Reads the happens-before edges of a text HBlog */
+    BOOL readHBlog(const char *logName, Checker &checker);
+
+    /** Reads the events of a text Tracelog */
+    BOOL readTrace(const char *logName, Checker &checker);
+
+    /**
+     * Processes the lines in [pos, end), returns false on error.
+     * Snapshots are taken if "trace", where the file begins, is
+     * given.
+     */
+    BOOL processLines(const char *pos, const char *end,
+                      Checker &checker, const char *trace = NULL);
+
+  private:
+    // processes a single line without the '\n'
+    BOOL processLine(const char *pos, const char *end,
+                     Checker &checker);
+
+    // scans a memory action: "addr value lineNo funcId"
+    BOOL scanAction(const char *&pos, const char *end,
+                    BOOL isWrite, Action &action);
+
+    // reused for task and function names
+    std::string name;
+};
+
+#endif // end textTrace.hpp
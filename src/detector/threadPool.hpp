@@ -0,0 +1,117 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines a fixed pool of worker threads. run() executes a batch
+// of independent jobs on the workers and the calling thread and
+// returns when all jobs of the batch have finished.
+
+#ifndef _DETECTOR_THREADPOOL_HPP_
+#define _DETECTOR_THREADPOOL_HPP_
+
+#include "defs.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class ThreadPool {
+  public:
+    /** Creates a pool which runs jobs on "threads" threads in total */
+    explicit ThreadPool(size_t threads)
+        : generation(0), busyWorkers(0), jobCount(0),
+          nextJob(0), stopping(false) {
+      // the calling thread is one of the threads
+      for (size_t i = 1; i < threads; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+      }
+    }
+
+    ~ThreadPool() {
+      {
+        std::lock_guard<std::mutex> lock(guard);
+        stopping = true;
+      }
+      wakeUp.notify_all();
+      for (auto &worker : workers) worker.join();
+    }
+
+    size_t size() const { return workers.size() + 1; }
+
+    /** Runs job(0) ... job(jobs - 1) and waits for all of them */
+    VOID run(size_t jobs, const std::function<void(size_t)> &job) {
+      if ( workers.empty() || jobs <= 1 ) { // nothing to share
+        for (size_t i = 0; i < jobs; i++) job(i);
+        return;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(guard);
+        currentJob  = &job;
+        jobCount    = jobs;
+        nextJob     = 0;
+        busyWorkers = workers.size();
+        generation++;
+      }
+      wakeUp.notify_all();
+
+      runJobs(job);
+
+      // wait for the workers to finish the batch
+      std::unique_lock<std::mutex> lock(guard);
+      batchDone.wait(lock, [this] { return busyWorkers == 0; });
+      currentJob = NULL;
+    }
+
+  private:
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    // takes jobs of the current batch until none is left
+    VOID runJobs(const std::function<void(size_t)> &job) {
+      for (size_t i = nextJob++; i < jobCount; i = nextJob++) {
+        job(i);
+      }
+    }
+
+    VOID workerLoop() {
+      size_t seen = 0; // last batch served
+      while ( true ) {
+        const std::function<void(size_t)> *job;
+        {
+          std::unique_lock<std::mutex> lock(guard);
+          wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+          if ( stopping ) return;
+          seen = generation;
+          job  = currentJob;
+        }
+
+        runJobs(*job);
+
+        std::lock_guard<std::mutex> lock(guard);
+        if (--busyWorkers == 0) batchDone.notify_one();
+      }
+    }
+
+    std::vector<std::thread>                   workers;
+    std::mutex                                 guard;
+    std::condition_variable                    wakeUp;
+    std::condition_variable                    batchDone;
+    const std::function<void(size_t)>         *currentJob = NULL;
+    size_t                                     generation;
+    size_t                                     busyWorkers;
+    size_t                                     jobCount;
+    std::atomic<size_t>                        nextJob;
+    bool                                       stopping;
+};
+
+#endif // end threadPool.hpp
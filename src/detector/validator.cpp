@@ -17,12 +17,228 @@
 #include "conflictReport.hpp"
 #include "validator.hpp"
 
-VOID BugValidator::parseTasksIR(char *IRlogName) {
-  std::vector<Instruction> *currentTask = NULL;
-  std::string sttmt; // program statement
-  std::ifstream IRcode(IRlogName); //  open IRlog file
+VOID BugValidator::indexTasksIR(const char *IRlogName) {
+  size_t tasksNo = 0;
+  if ( IRfile.open(IRlogName) ) {
+    cacheName  = std::string(IRlogName) + IRCACHE_SUFFIX;
+    sourceHash = IRCache::hash(IRfile.begin(), IRfile.size());
+    cached     = loadIRcache(tasksNo);
+    if ( !cached ) tasksNo = indexText();
+  }
+  taskGuards.reset( new std::mutex[Tasks.size()] );
+  tasksIndexed = tasksNo;
+  std::cout << "Tasks no: " << tasksNo << std::endl;
+}
+
+size_t BugValidator::indexText() {
+  size_t tasksNo = 0;
+  const char *pos = IRfile.begin();
+  const char *end = IRfile.end();
+  INTEGER currentTask = -1;
+
+  while (pos < end) {
+    const char *eol = static_cast<const char *>(
+        memchr(pos, '\n', end - pos));
+    if ( !eol ) eol = end;
+
+    const char *first = pos;
+    const char *last  = eol;
+    while (first < last && *first == ' ') first++;
+    while (last > first && last[-1] == ' ') last--;
+
+    // a task name has no spaces, unlike the statements
+    if (first < last && !memchr(first, ' ', last - first)) {
+      if (currentTask >= 0) Tasks[currentTask].end = pos;
+
+      currentTask = names.intern(std::string(first, last));
+      if (currentTask >= static_cast<INTEGER>(Tasks.size())) {
+        Tasks.resize(currentTask + 1);
+      }
+      TaskIR &task = Tasks[currentTask];
+      if ( !task.begin ) tasksNo++;
+      task.begin  = eol < end ? eol + 1 : end;
+      task.end    = end;
+      task.parsed = false; // a repeated task replaces the earlier
+      task.body.clear();
+    }
+    pos = eol + 1;
+  }
+  return tasksNo;
+}
+
+BOOL BugValidator::loadIRcache(size_t &tasksNo) {
+  if ( !cacheFile.open(cacheName.c_str()) ) return false;
+
+  const IRCache::FileHeader *header =
+      reinterpret_cast<const IRCache::FileHeader *>(cacheFile.begin());
+  if ( !IRCache::isValidHeader(*header, cacheFile.size(),
+                               sourceHash, IRfile.size()) ) {
+    cacheFile.close(); // stale or broken, parse the IR file
+    return false;
+  }
+
+  const IRCache::TaskRecord *tasks =
+      reinterpret_cast<const IRCache::TaskRecord *>(header + 1);
+  const IRCache::InstructionRecord *records =
+      reinterpret_cast<const IRCache::InstructionRecord *>(
+          tasks + header->tasks);
+  const char *strings = reinterpret_cast<const char *>(
+      records + header->instructions);
+
+  for (uint32_t i = 0; i < header->tasks; i++) {
+    const IRCache::TaskRecord &record = tasks[i];
+    if (record.first > header->instructions ||
+        record.count > header->instructions - record.first ||
+        record.name.offset > header->stringsSize ||
+        record.name.size > header->stringsSize - record.name.offset ||
+        record.textOffset > IRfile.size() ||
+        record.textSize > IRfile.size() - record.textOffset) {
+      Tasks.clear();
+      cacheFile.close();
+      return false;
+    }
+
+    INTEGER taskName = names.intern(std::string(
+        strings + record.name.offset, record.name.size));
+    if (taskName >= static_cast<INTEGER>(Tasks.size())) {
+      Tasks.resize(taskName + 1);
+    }
+    TaskIR &task = Tasks[taskName];
+    task.begin = IRfile.begin() + record.textOffset;
+    task.end   = task.begin + record.textSize;
+    if ( record.parsed ) { // else parsed from the IR when used
+      task.first = records + record.first;
+      task.last  = records + record.first + record.count;
+    }
+  }
+  tasksNo = header->tasks;
+  return true;
+}
+
+VOID BugValidator::writeIRcache() {
+  if ( !IRfile.begin() ) return; // no IR
+
+  // up to date if no task was parsed from the IR in this run
+  BOOL parsedText = false;
+  for (const auto &task : Tasks) {
+    parsedText = parsedText || (task.begin && task.parsed && !task.first);
+  }
+  if (cached && !parsedText) return;
+
+  std::vector<IRCache::TaskRecord>          tasks;
+  std::vector<IRCache::InstructionRecord>   records;
+  std::string                               strings;
+  std::unordered_map<std::string, IRCache::StringRef> stored;
+
+  // stores each distinct string once
+  auto storeString = [&](const std::string &text) {
+    auto found = stored.find(text);
+    if (found != stored.end()) return found->second;
+    IRCache::StringRef ref;
+    ref.offset = strings.size();
+    ref.size   = text.size();
+    strings   += text;
+    stored[text] = ref;
+    return ref;
+  };
+
+  // the tasks parsed, in this run or an earlier one, keep their
+  // instructions; the others are parsed from the IR when used
+  for (size_t name = 0; name < Tasks.size(); name++) {
+    const TaskIR &task = Tasks[name];
+    if ( !task.begin ) continue;
+
+    std::vector<Instruction> cachedBody;
+    if (!task.parsed && task.first) readTask(task, cachedBody);
+    const std::vector<Instruction> &body =
+        task.parsed ? task.body : cachedBody;
+
+    IRCache::TaskRecord taskRecord = IRCache::TaskRecord();
+    taskRecord.name       = storeString( names.name(name) );
+    taskRecord.first      = records.size();
+    taskRecord.count      = body.size();
+    taskRecord.parsed     = task.parsed || task.first;
+    taskRecord.textOffset = task.begin - IRfile.begin();
+    taskRecord.textSize   = task.end - task.begin;
+    tasks.push_back(taskRecord);
+
+    for (const auto &instr : body) {
+      IRCache::InstructionRecord record;
+      record.oper        = instr.oper;
+      record.lineNo      = instr.lineNo;
+      record.destination = storeString( instr.destination );
+      record.type        = storeString( instr.type );
+      record.operand1    = storeString( instr.operand1 );
+      record.operand2    = storeString( instr.operand2 );
+      record.raw         = storeString( instr.raw );
+      records.push_back(record);
+    }
+  }
+  if (strings.size() > UINT32_MAX || records.size() > UINT32_MAX) {
+    return; // too large for the cache
+  }
+
+  IRCache::FileHeader header;
+  header.sourceHash   = sourceHash;
+  header.sourceSize   = IRfile.size();
+  header.tasks        = tasks.size();
+  header.instructions = records.size();
+  header.recordSize   = sizeof(IRCache::InstructionRecord);
+  header.stringsSize  = strings.size();
+
+  // runs sharing the IR file replace the cache as a whole
+  std::string tempName = cacheName + "." + std::to_string(getpid());
+  std::ofstream cache(tempName, std::ios::binary);
+  cache.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  cache.write(reinterpret_cast<const char *>(tasks.data()),
+              tasks.size() * sizeof(IRCache::TaskRecord));
+  cache.write(reinterpret_cast<const char *>(records.data()),
+              records.size() * sizeof(IRCache::InstructionRecord));
+  cache.write(strings.data(), strings.size());
+  cache.close();
+
+  if ( !cache || rename(tempName.c_str(), cacheName.c_str()) != 0 ) {
+    unlink(tempName.c_str());
+  }
+}
+
+VOID BugValidator::readTask(const TaskIR &task,
+                            std::vector<Instruction> &body) {
+  if ( task.first ) { // parsed by an earlier run
+    const IRCache::FileHeader *header =
+        reinterpret_cast<const IRCache::FileHeader *>(cacheFile.begin());
+    const char *strings = cacheFile.end() - header->stringsSize;
+    auto text = [&](const IRCache::StringRef &ref) {
+      if (ref.offset > header->stringsSize ||
+          ref.size > header->stringsSize - ref.offset) {
+        return std::string(); // broken
+      }
+      return std::string(strings + ref.offset, ref.size);
+    };
+
+    body.reserve(task.last - task.first);
+    for (auto record = task.first; record < task.last; record++) {
+      Instruction instr;
+      instr.oper        = static_cast<OPERATION>(record->oper);
+      instr.lineNo      = record->lineNo;
+      instr.destination = text(record->destination);
+      instr.type        = text(record->type);
+      instr.operand1    = text(record->operand1);
+      instr.operand2    = text(record->operand2);
+      instr.raw         = text(record->raw);
+      body.push_back( std::move(instr) );
+    }
+    return;
+  }
+
+  const char *pos = task.begin;
+  while (pos < task.end) {
+    const char *eol = static_cast<const char *>(
+        memchr(pos, '\n', task.end - pos));
+    if ( !eol ) eol = task.end;
+    std::string sttmt(pos, eol); // program statement
+    pos = eol + 1;
 
-  while ( getline( IRcode, sttmt ) ) {
     if ( isEmpty(sttmt) ) continue; // skip empty line
     if ( isDebugCall(sttmt) ) continue; // skip debug call
 
@@ -38,17 +254,7 @@ VOID BugValidator::parseTasksIR(char *IRlogName) {
           sttmt.find_first_not_of(' ', sttmt.find_first_of(' ')) );
       Instruction instr( sttmt );
       instr.lineNo = lineNo;
-      currentTask->push_back(instr);
-      continue;
-    }
-
-    if ( isTaskName(sttmt) ) { // else a new task name
-#ifdef DEBUG
-      std::cout << "Task name: " << sttmt << std::endl;
-#endif
-      Tasks[sttmt] = std::vector<Instruction>();
-      currentTask  = &Tasks[sttmt];
-      //map<string, map<INTEGER, std::vector<string>>> Tasks;
+      body.push_back( std::move(instr) );
       continue;
     }
 
@@ -58,8 +264,53 @@ VOID BugValidator::parseTasksIR(char *IRlogName) {
               << sttmt << std::endl;
 #endif
   }
-  IRcode.close();
-  std::cout << "Tasks no: " << Tasks.size() << std::endl;
+}
+
+VOID BugValidator::parseTask(TaskIR &task) {
+  auto begin = std::chrono::steady_clock::now();
+  readTask(task, task.body);
+  indexTask(task);
+  task.parsed = true;
+
+  tasksParsed++;
+  instructionsParsed += task.body.size();
+  parseTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - begin ).count();
+}
+
+VOID BugValidator::indexTask(TaskIR &task) {
+  task.lineBound.reserve(task.body.size());
+  task.lines.reserve(task.body.size());
+  task.definitions.reserve(task.body.size());
+
+  INTEGER bound = 0;
+  for (size_t i = 0; i < task.body.size(); i++) {
+    const Instruction &instr = task.body[i];
+    INTEGER index = static_cast<INTEGER>(i);
+
+    bound = std::max(bound, instr.lineNo);
+    task.lineBound.push_back(bound);
+    task.lines.push_back( std::make_pair(instr.lineNo, index) );
+
+    switch (instr.oper) {
+      case ALLOCA:
+      case BITCAST:
+      case STORE:
+      case LOAD:
+      case ADD:
+      case SUB:
+      case MUL:
+      case DIV:
+        task.definitions[instr.destination].push_back(index);
+        break;
+      case CALL:
+        task.calls.push_back(index);
+        break;
+      default:
+        break;
+    }
+  }
+  std::sort(task.lines.begin(), task.lines.end());
 }
 
 
@@ -70,138 +321,174 @@ VOID BugValidator::parseTasksIR(char *IRlogName) {
 VOID BugValidator::validate(Report &conflictSet) {
 
   // get task names
-  std::string task1 = conflictSet.task1Name;
-  std::string task2 = conflictSet.task2Name;
+  INTEGER task1 = conflictSet.task1Name;
+  INTEGER task2 = conflictSet.task2Name;
 
   // for each action pair
-  auto  conflict  = conflictSet.buggyAccesses.begin();
-  while (conflict != conflictSet.buggyAccesses.end()) {
-
+  conflictSet.buggyAccesses.eraseIf([&](const Conflict &conflict) {
      // skip commutativity check if read-write conflict
-     if (conflict->action1.isWrite != conflict->action2.isWrite) {
-       conflict++;
-       continue;
+     if (conflict.action1.isWrite != conflict.action2.isWrite) {
+       return false;
      }
 #ifdef DEBUG
-     std::cout << task1 << " <--> "<< task2 << std::endl;
+     std::cout << names.name(task1) << " <--> "
+               << names.name(task2) << std::endl;
 #endif
-     INTEGER line1 = conflict->action1.lineNo;
-     INTEGER line2 = conflict->action2.lineNo;
+     INTEGER line1 = conflict.action1.lineNo;
+     INTEGER line2 = conflict.action2.lineNo;
 #ifdef DEBUG
      std::cout << "Lines " << line1 << " <--> " << line2 << std::endl;
 #endif
-     operationSet.clear(); // clear set of commuting operations
-
-     // check if line1 operations commute
-     if ( involveSimpleOperations( task1, line1 ) &&
-       // check if line2 operations commute
-       involveSimpleOperations( task2, line2 )) {
-       //it->second.erase(temPair);
-       conflict = conflictSet.buggyAccesses.erase( conflict );
+     // check if line1 and line2 operations commute
+     Verdict verdict1 = lineVerdict( task1, line1 );
+     Verdict verdict2 = lineVerdict( task2, line2 );
+     BOOL safe = verdict1.safe && verdict2.safe &&
+                 OperationSet::commute(verdict1.groups, verdict2.groups);
+     conflictsChecked++;
+     if ( safe ) conflictsCommuting++;
 #ifdef DEBUG
+     if ( safe ) {
        std::cout << "THERE IS SAFETY line1: " << line1
                  << " line2: " << line2 << std::endl;
-#endif
-     } else {
-       conflict++;
      }
-  }
+#endif
+     return safe;
+  });
 }
 
-BOOL BugValidator::involveSimpleOperations(
-    std::string taskName,
+BugValidator::Verdict BugValidator::lineVerdict(
+    INTEGER taskName,
     INTEGER lineNumber) {
+  Verdict verdict = { false, 0 };
 
   // get the instructions of a task
-  std::vector<Instruction> &taskBody = Tasks[taskName];
-  Instruction instr;
-  INTEGER index = -1;
+  if (taskName < 0 || taskName >= static_cast<INTEGER>(Tasks.size()) ||
+      !Tasks[taskName].begin) {
+    return verdict; // no instructions
+  }
+  TaskIR &task = Tasks[taskName];
+  std::lock_guard<std::mutex> lock( taskGuards[taskName] );
+  if ( !task.parsed ) parseTask(task);
+
+  auto found = task.verdicts.find(lineNumber);
+  if (found != task.verdicts.end()) return found->second;
+
+  lineVerdicts++;
+  OperationSet operations; // the commuting operations
+  verdict.safe   = involveSimpleOperations(task, lineNumber, operations);
+  verdict.groups = operations.groups();
+  return task.verdicts[lineNumber] = verdict;
+}
+
+BOOL BugValidator::involveSimpleOperations(
+    const TaskIR &task,
+    INTEGER lineNumber,
+    OperationSet &operations) {
 
-  for (const auto& inst : taskBody) {
-     if (inst.lineNo > lineNumber) break;
-     if (inst.lineNo == lineNumber) instr  = inst;
-     index++;
+  // the instructions before the first one past the line
+  INTEGER index = std::upper_bound(task.lineBound.begin(),
+                                   task.lineBound.end(), lineNumber) -
+                  task.lineBound.begin() - 1;
+
+  // the last instruction of the line among them
+  auto entry = std::upper_bound(task.lines.begin(), task.lines.end(),
+                                std::make_pair(lineNumber, index));
+  if (entry == task.lines.begin() || (--entry)->first != lineNumber) {
+    return false;
   }
+  const Instruction &instr = task.body[entry->second];
 #ifdef DEBUG
-  std::cout << "SAFET " << taskName << " " << instr.destination
+  std::cout << "SAFET " << instr.destination
             << ", idx: "<< index << std::endl;
 #endif
   // expected to be a store
   if (instr.oper == STORE) {
-    return isSafe(taskBody, index, instr.operand1);
+    return isSafe(task, index, instr.operand1, operations);
   }
   return false;
 }
 
-bool BugValidator::isSafe(
-    const std::vector<Instruction> &taskBody,
+INTEGER BugValidator::lastUse(
+    const TaskIR &task,
     INTEGER loc,
-    std::string operand) {
-
-  if (loc < 0) {
-      return true;
-  }
-
-  Instruction instr = taskBody.at(loc);
-  if (instr.oper == ALLOCA && instr.destination == operand) {
-      return true;
-  }
+    const std::string &operand) {
 
-  if ( instr.oper == BITCAST ) {
-    // destination has been casted from a different address
-    if ( instr.destination == operand) {
-      return isSafe(taskBody, loc-1, instr.operand1);
-    } else {
-      return isSafe(taskBody, loc-1, operand);
-    }
+  INTEGER use = -1;
+  auto defs = task.definitions.find(operand);
+  if (defs != task.definitions.end()) {
+    auto def = std::upper_bound(defs->second.begin(),
+                                defs->second.end(), loc);
+    if (def != defs->second.begin()) use = *(--def);
   }
 
   // used as parameter somewhere and might be a pointer
-  if (instr.oper == CALL) {
-    if (instr.raw.find(operand) != std::string::npos) {
-      return false;
-    } else {
-      return isSafe(taskBody, loc-1, operand);
+  auto call = std::upper_bound(task.calls.begin(), task.calls.end(), loc);
+  while (call != task.calls.begin() && *(--call) > use) {
+    if (task.body[*call].raw.find(operand) != std::string::npos) {
+      return *call;
     }
   }
+  return use;
+}
+
+/**
+ * Traces "operand" back from instruction "loc" to where it is
+ * allocated, through the instructions which compute it.
+ */
+bool BugValidator::isSafe(
+    const TaskIR &task,
+    INTEGER loc,
+    const std::string &operand,
+    OperationSet &operations) {
 
-  // ADD or SUB or MUL or DIV
-  if (instr.oper == ADD || instr.oper == SUB ||
-      instr.oper == MUL || instr.oper == DIV) {
-    if (instr.destination == operand) {
+  // the operands still to trace, depth first
+  std::vector<std::pair<INTEGER, std::string>> operands;
+  UNORD_INTSET traced; // the instructions followed
+  operands.push_back( std::make_pair(loc, operand) );
 
-      // return immediately is operation can not
-      // commute with previous operations
-      if (! operationSet.isCommutative(instr.oper ) ) {
-        return false;
-      }
-      // append the commutative operation
-      operationSet.appendOperation( instr.oper );
-
-      bool t1 = isSafe(taskBody, loc-1, instr.operand1);
-      bool t2 = isSafe(taskBody, loc-1, instr.operand2);
-      return t1 && t2;
-    } else {
-      return isSafe(taskBody, loc-1, operand);
-    }
-  }
+  while ( !operands.empty() ) {
+    std::pair<INTEGER, std::string> next = std::move(operands.back());
+    operands.pop_back();
 
-  // STORE
-  if (instr.oper == STORE) {
-    if (instr.destination == operand) {
-      return isSafe(taskBody, loc-1, instr.operand1);
-    } else {
-      return isSafe(taskBody, loc-1, operand);
-    }
-  }
+    INTEGER use = lastUse(task, next.first, next.second);
+    if (use < 0) continue; // defined outside
+    if ( !traced.insert(use).second ) continue; // found safe before
 
-  // load
-  if (instr.oper == LOAD) {
-    if (instr.destination == operand) {
-      return isSafe(taskBody, loc-1, instr.operand1);
+    const Instruction &instr = task.body[use];
+    switch (instr.oper) {
+      case ALLOCA:
+        break;
+      case CALL:
+        return false;
+      case ADD:
+      case SUB:
+      case MUL:
+      case DIV:
+        // return immediately is operation can not
+        // commute with previous operations
+        if ( !operations.isCommutative(instr.oper) ) return false;
+        // append the commutative operation
+        operations.appendOperation(instr.oper);
+
+        operands.push_back( std::make_pair(use - 1, instr.operand2) );
+        operands.push_back( std::make_pair(use - 1, instr.operand1) );
+        break;
+      default: // BITCAST, STORE or LOAD
+        operands.push_back( std::make_pair(use - 1, instr.operand1) );
+        break;
     }
   }
+  return true;
+}
 
-  return isSafe(taskBody, loc-1, operand);
-  // GETEMEMENTSPTR
+// Adds the work of the validator to the profile
+VOID BugValidator::addCounters(Profiler &profiler) const {
+  profiler.setCounter("ir_tasks_indexed", tasksIndexed);
+  profiler.setCounter("ir_cache_used", cached ? 1 : 0);
+  profiler.setCounter("ir_tasks_parsed", tasksParsed.load());
+  profiler.setCounter("ir_instructions_parsed", instructionsParsed.load());
+  profiler.setCounter("ir_parse_seconds", parseTime.load() / 1e9);
+  profiler.setCounter("line_verdicts", lineVerdicts.load());
+  profiler.setCounter("conflicts_validated", conflictsChecked.load());
+  profiler.setCounter("conflicts_commuting", conflictsCommuting.load());
 }
@@ -20,21 +20,108 @@
 #include "conflictReport.hpp"
 #include "defs.hpp"
 #include "instruction.hpp"
+#include "irCache.hpp"
+#include "mappedFile.hpp"
 #include "operationSet.hpp"
-
+#include "nameInterner.hpp"
+#include "profiler.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+// Reports can be validated concurrently: the tasks are parsed and
+// their verdicts cached under a lock per task.
 class BugValidator {
 
   public:
-    VOID parseTasksIR(char *IRlogName);
+    // task names are interned in "names", shared with the checker
+    explicit BugValidator(NameInterner &names_)
+        : names(names_), sourceHash(0), cached(false), tasksIndexed(0),
+          tasksParsed(0), instructionsParsed(0), parseTime(0),
+          lineVerdicts(0), conflictsChecked(0), conflictsCommuting(0) {}
+
+    /**
+     * Indexes the tasks of the IR file, parsed when first used,
+     * or loads them from its cache if it is up to date
+     */
+    VOID indexTasksIR(const char *IRlogName);
+
+    /**
+     * Writes the cache of the IR file for the next runs, with the
+     * tasks parsed so far; nothing if the cache has them all
+     */
+    VOID writeIRcache();
+
+    /** Removes the accesses of commuting operations from "report" */
     void validate(Report &report);
 
-  private:
-    std::unordered_map<std::string, std::vector<Instruction>> Tasks;
-    bool involveSimpleOperations(std::string task1, INTEGER line1);
-    bool isSafe(const std::vector<Instruction> &trace,
-                INTEGER loc, std::string operand);
+    /** Adds the counters of the validator to "profiler" */
+    VOID addCounters(Profiler &profiler) const;
 
-    OperationSet operationSet;
+  private:
+    // the safety of the store on a line: whether the operations
+    // it depends on commute, and their groups (OperationSet)
+    struct Verdict {
+      BOOL      safe;
+      unsigned  groups;
+    };
+
+    // the IR lines of a task, its records in the cache if it was
+    // parsed by an earlier run, and its instructions once parsed
+    struct TaskIR {
+      TaskIR(): begin(NULL), end(NULL), first(NULL), last(NULL),
+                parsed(false) {}
+
+      const char                *begin; // NULL if not in the IR
+      const char                *end;
+      const IRCache::InstructionRecord  *first; // NULL if not cached
+      const IRCache::InstructionRecord  *last;
+      BOOL                       parsed;
+      std::vector<Instruction>   body;
+
+      // indexes of the body, built when parsed
+      std::vector<INTEGER>                        lineBound; // running max
+      std::vector<std::pair<INTEGER, INTEGER>>    lines; // (line, index)
+      std::unordered_map<std::string, INTVECTOR>  definitions;
+      INTVECTOR                                   calls;
+
+      std::unordered_map<INTEGER, Verdict>        verdicts; // per line
+    };
+
+    NameInterner                &names;
+    MappedFile                   IRfile;
+    MappedFile                   cacheFile;
+    std::string                  cacheName;
+    uint64_t                     sourceHash; // of the IR file
+    BOOL                         cached; // tasks indexed by the cache
+    std::vector<TaskIR>          Tasks; // per interned name
+    std::unique_ptr<std::mutex[]> taskGuards; // per task
+
+    // counters for --profile, updated by the validating threads
+    size_t                       tasksIndexed;
+    std::atomic<size_t>          tasksParsed;
+    std::atomic<size_t>          instructionsParsed;
+    std::atomic<uint64_t>        parseTime; // nanoseconds, all threads
+    std::atomic<size_t>          lineVerdicts; // computed
+    std::atomic<size_t>          conflictsChecked; // write-write
+    std::atomic<size_t>          conflictsCommuting;
+
+    size_t indexText();
+    BOOL loadIRcache(size_t &tasksNo);
+    VOID readTask(const TaskIR &task, std::vector<Instruction> &body);
+    VOID parseTask(TaskIR &task);
+    VOID indexTask(TaskIR &task);
+
+    Verdict lineVerdict(INTEGER taskName, INTEGER line);
+    bool involveSimpleOperations(const TaskIR &task, INTEGER line,
+                                 OperationSet &operations);
+    bool isSafe(const TaskIR &task, INTEGER loc,
+                const std::string &operand, OperationSet &operations);
+
+    // the last instruction at or before "loc" which defines
+    // "operand" or passes it to a call, -1 if none
+    INTEGER lastUse(const TaskIR &task, INTEGER loc,
+                    const std::string &operand);
 
     // Helper functions
     inline bool isEmpty(const std::string& statement) {
@@ -47,7 +134,9 @@ class BugValidator {
 
     inline bool isValid(const std::string& sttmt) {
       // valid starts with line number, e.g. "42: "
-      return std::regex_search (sttmt, std::regex("^[0-9]+: "));
+      size_t digits = 0;
+      while (digits < sttmt.size() && isdigit(sttmt[digits])) digits++;
+      return digits > 0 && sttmt.compare(digits, 2, ": ") == 0;
     }
 
     inline bool isTaskName(const std::string& sttmt) {
@@ -58,16 +147,19 @@ class BugValidator {
      * Returns the line number from the IR statement string
      */
     INTEGER getLineNumber(const std::string & sttmt) {
-      std::smatch result; // get line number
-      std::regex_search(sttmt, result, std::regex("^[0-9]+") );
+      INTEGER lineNo = 0; // get line number
+      size_t  digits = 0;
+      for (; digits < sttmt.size() && isdigit(sttmt[digits]); digits++) {
+        lineNo = lineNo * 10 + (sttmt[digits] - '0');
+      }
 
-      if (result.size() <= 0 || result.size()> 1 ) {
+      if ( !digits ) {
         // a line should have only one line number
         std::cerr << "Incorrect number of lines: "
                   << sttmt << std::endl;
         exit(EXIT_FAILURE);
       }
-      return stoul(result[0]);
+      return lineNo;
     }
 
     Instruction makeStoreInstruction(
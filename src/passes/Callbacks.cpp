@@ -66,11 +66,9 @@ void INS_Fini() {
 
 void INS_TaskBeginFunc( void *taskName ) {
 
-  auto threadID     = static_cast<uint>( pthread_self() );
-  taskInfo.threadID = threadID;
-  taskInfo.taskID   = INS::GenTaskID();
-  taskInfo.taskName = (char *)taskName;
-  taskInfo.active   = true;
+  // the state of the previous task of this thread is reset
+  auto threadID = static_cast<uint>( pthread_self() );
+  taskInfo.beginTask( threadID, INS::GenTaskID(), (char *)taskName );
 
 #ifdef DEBUG
   std::cout << "Task_Began, (threadID: "
@@ -17,12 +17,35 @@
 // static attributes redefined
 std::mutex INS::guardLock;
 
-FILEPTR INS::logger;
+TraceOutput INS::logger;
 
-FILEPTR INS::HBlogger;
+// stopped before the logger is closed
+TraceQueue INS::loggerQueue;
+
+SharedRing INS::ring;
+
+TraceOutput INS::HBlogger;
 
 std::ostringstream INS::HBloggerBuffer;
 
+bool INS::binaryTrace = false;
+
+bool INS::streaming = false;
+
+bool INS::sharded = false;
+
+std::atomic<INTEGER> INS::blockSeed{ 0 };
+
+std::vector<TraceShard *> INS::shards;
+
+std::mutex INS::shardsLock;
+
+INTEGER INS::shardGeneration = 0;
+
+std::string INS::logTime;
+
+std::string INS::logSuffix;
+
 std::atomic<INTEGER> INS::taskIDSeed{ 0 };
 
 std::unordered_map<STRING, INTEGER> INS::funcNames;
@@ -0,0 +1,148 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the table of the memory accesses of the running task,
+// one per thread. Every instrumented load and store looks its
+// address up here, so the table is an open addressing hash table
+// of small slots pointing into an arena of POD records. The records
+// are allocated one after the other and the table is emptied in
+// O(1) at the end of a task: the arena is rewound and the slots
+// of earlier tasks are told apart by their generation. The memory
+// is kept for the next task, unless a task made it larger than
+// ACCESS_TABLE_KEEP_RECORDS.
+
+#ifndef _PASSES_INCLUDES_ACCESSTABLE_HPP_
+#define _PASSES_INCLUDES_ACCESSTABLE_HPP_
+
+#include "defs.hpp"
+#include <cstdint>
+#include <vector>
+
+// the slots of a new table, a power of two
+#define ACCESS_TABLE_SLOTS 1024
+
+// the records kept for the next task, about 40 MB with the slots
+#define ACCESS_TABLE_KEEP_RECORDS (1 << 20)
+
+// the access of a task to an address written to the trace: its
+// first access, replaced by every later write
+typedef struct TaskAccess {
+  ADDRESS  addr;
+  INTEGER  value;
+  INTEGER  lineNo;
+  INTEGER  funcId;
+  bool     isWrite;
+} TaskAccess;
+
+class AccessTable {
+  public:
+    AccessTable(): records(0), generation(1) {
+      slots.resize(ACCESS_TABLE_SLOTS);
+      arena.resize(ACCESS_TABLE_SLOTS / 2);
+    }
+
+    /**
+     * Returns the record of "addr", a new one if the task did not
+     * access it yet ("inserted" is then true).
+     */
+    inline TaskAccess &insert(ADDRESS addr, bool &inserted) {
+      size_t mask = slots.size() - 1;
+      for (size_t i = slotOf(addr) & mask; ; i = (i + 1) & mask) {
+        Slot &slot = slots[i];
+        if (slot.generation != generation) { // free in this task
+          inserted = true;
+          return allocate(slot, addr);
+        }
+        if (arena[slot.record].addr == addr) {
+          inserted = false;
+          return arena[slot.record];
+        }
+      }
+    }
+
+    /** Forgets all the records, keeping the memory up to a bound */
+    inline VOID reset() {
+      if (arena.size() > ACCESS_TABLE_KEEP_RECORDS) {
+        release();
+        return;
+      }
+
+      records = 0;
+      if (++generation == 0) { // the stamps wrapped around
+        for (auto &slot : slots) slot.generation = 0;
+        generation = 1;
+      }
+    }
+
+    inline size_t size() const { return records; }
+
+    /** The records in the order they were inserted */
+    inline const TaskAccess *begin() const { return arena.data(); }
+    inline const TaskAccess *end()   const { return arena.data() + records; }
+
+  private:
+    typedef struct Slot {
+      uint32_t  generation = 0; // of the task which used it
+      uint32_t  record     = 0; // index in the arena
+    } Slot;
+
+    // Neighbouring words go to neighbouring slots, which keeps the
+    // scans of arrays in the cache; the higher bits folded in break
+    // up the strides of a power of two.
+    static inline size_t slotOf(ADDRESS addr) {
+      uint64_t key = reinterpret_cast<uint64_t>(addr) >> 3;
+      return static_cast<size_t>(key ^ (key >> 9) ^ (key >> 21));
+    }
+
+    // takes the next record of the arena for the free "slot"
+    inline TaskAccess &allocate(Slot &slot, ADDRESS addr) {
+      if (records == arena.size()) arena.resize(arena.size() * 2);
+
+      slot.generation = generation;
+      slot.record     = static_cast<uint32_t>(records);
+      TaskAccess &record = arena[records++];
+      record.addr = addr;
+
+      // at most half full, to keep the probes short
+      if (records * 2 > slots.size()) grow();
+      return arena[records - 1];
+    }
+
+    // gives the memory of a large task back: a new, small table
+    VOID release() {
+      std::vector<Slot>(ACCESS_TABLE_SLOTS).swap(slots);
+      std::vector<TaskAccess>(ACCESS_TABLE_SLOTS / 2).swap(arena);
+      records    = 0;
+      generation = 1;
+    }
+
+    // doubles the slots and inserts the records again
+    VOID grow() {
+      slots.assign(slots.size() * 2, Slot());
+      generation = 1;
+
+      size_t mask = slots.size() - 1;
+      for (size_t r = 0; r < records; r++) {
+        size_t i = slotOf(arena[r].addr) & mask;
+        while (slots[i].generation == generation) i = (i + 1) & mask;
+        slots[i].generation = generation;
+        slots[i].record     = static_cast<uint32_t>(r);
+      }
+    }
+
+    std::vector<Slot>        slots;
+    std::vector<TaskAccess>  arena;
+    size_t                   records;    // used in the arena
+    uint32_t                 generation; // of the running task
+};
+
+#endif // end AccessTable.hpp
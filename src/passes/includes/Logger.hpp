@@ -17,6 +17,11 @@
 
 #include "TaskInfo.hpp"
 #include "defs.hpp"
+#include "traceFormat.hpp"
+#include "TraceOutput.hpp"
+#include "TraceQueue.hpp"
+#include "TraceShard.hpp"
+#include "traceRing.hpp"
 
 #include <atomic>
 #include <mutex>
@@ -41,13 +46,73 @@ class INS {
     // a strictly increasing value, used as tasks unique id generator
     static std::atomic<INTEGER>                 taskIDSeed;
 
-    // a file pointer for the log file
-    static FILEPTR                              logger;
+    // the log file, or the stream to a running checker
+    static TraceOutput                          logger;
 
-    // a file pointer for the HB log file
-    static FILEPTR                              HBlogger;
+    // the chunks of events written to the logger by a thread
+    // of its own, so that tasks do not wait for the log
+    static TraceQueue                           loggerQueue;
+
+    // the ring shared with a running checker (DFINSPEC_STREAM=
+    // ring:PATH); tasks write their events into it directly
+    static SharedRing                           ring;
+
+    // the HB log file, not used when streaming
+    static TraceOutput                          HBlogger;
     static std::ostringstream                   HBloggerBuffer;
 
+    // true if the logs are written in the binary format
+    // described in traceFormat.hpp instead of text
+    static bool                                 binaryTrace;
+
+    // true if the events are streamed to a running checker,
+    // which takes the HB edges from the token receive events
+    static bool                                 streaming;
+
+    // true if every thread writes its own shard of the logs; the
+    // logger and the HBlogger then list the shards (manifests)
+    static bool                                 sharded;
+
+    // numbers the task blocks of all shards in the order they end
+    static std::atomic<INTEGER>                 blockSeed;
+
+    // the shards of the threads, added when a thread logs first
+    static std::vector<TraceShard *>            shards;
+    static std::mutex                           shardsLock;
+
+    // the shards of an earlier Init are not used again
+    static INTEGER                              shardGeneration;
+
+    // the shard file names: prefix + "." + number + suffix
+    static std::string                          logTime;
+    static std::string                          logSuffix;
+
+    /** The shard of the calling thread, opened on its first event */
+    static inline TraceShard &ThreadShard() {
+      static thread_local TraceShard *shard = NULL;
+      static thread_local INTEGER generation = -1;
+      if ( shard && generation == shardGeneration ) return *shard;
+
+      // once per thread; threads may be created at any time
+      std::lock_guard<std::mutex> lock( shardsLock );
+      shard = new TraceShard();
+      generation = shardGeneration;
+      std::string name = "_" + logTime + "." +
+                         std::to_string( shards.size() ) + logSuffix;
+
+      if (! shard->trace.open( "Tracelog" + name ) ||
+          ! shard->HB.open( "HBlog" + name )) {
+        std::cerr << "Could not open log file \nExiting ...\n";
+        exit(EXIT_FAILURE);
+      }
+      if ( binaryTrace ) {
+        TraceFormat::writeHeader( shard->trace );
+        TraceFormat::writeHeader( shard->HB );
+      }
+      shards.push_back( shard );
+      return *shard;
+    }
+
     // storing function name pointers
     static std::unordered_map<STRING, INTEGER>  funcNames;
     static INTEGER                              funcIDSeed;
@@ -88,20 +153,75 @@ class INS {
       strftime( buff, 40, "%d-%m-%Y_%H.%M.%S", timeinfo );
       std::string timeStr( buff );
 
-      if (! logger.is_open() ) {
-        logger.open( "Tracelog_" + timeStr + ".txt",
-            std::ofstream::out | std::ofstream::trunc );
+      // the binary format is opt-in: DFINSPEC_TRACE_FORMAT=binary
+      const char *format = getenv("DFINSPEC_TRACE_FORMAT");
+      binaryTrace = format && std::string(format) == "binary";
+      std::string suffix = binaryTrace ? ".bin" : ".txt";
+
+      // online checking: DFINSPEC_STREAM=fifo or unix:socket
+      const char *stream = getenv("DFINSPEC_STREAM");
+      streaming = stream != NULL;
+
+      // a log per thread: DFINSPEC_TRACE_SHARDS=1, not streamed
+      const char *shardLogs = getenv("DFINSPEC_TRACE_SHARDS");
+      sharded = !streaming && shardLogs && std::string(shardLogs) == "1";
+      if ( sharded ) {
+        blockSeed = 0;
+        shardGeneration++;
+        logTime   = timeStr;
+        logSuffix = suffix;
       }
 
-      if (! HBlogger.is_open()) {
-        HBlogger.open( "HBlog_" + timeStr + ".txt",
-            std::ofstream::out | std::ofstream::trunc );
+      // or a ring shared with the checker: DFINSPEC_STREAM=ring:path,
+      // of DFINSPEC_RING_BYTES
+      size_t ringPrefixLen = strlen( TRACE_RING_PREFIX );
+      if (streaming &&
+          strncmp(stream, TRACE_RING_PREFIX, ringPrefixLen) == 0) {
+        const char *ringBytes = getenv("DFINSPEC_RING_BYTES");
+        size_t bytes = ringBytes ? strtoul(ringBytes, NULL, 10)
+                                 : TRACE_RING_BYTES;
+        if (! ring.create( stream + ringPrefixLen, bytes )) {
+          std::cerr << "Could not create the ring "
+                    << stream << "\nExiting ...\n";
+          exit(EXIT_FAILURE);
+        }
+      } else if ( streaming ) {
+        if (! logger.is_open() && ! logger.openStream( stream )) {
+          std::cerr << "Could not connect to the checker at "
+                    << stream << "\nExiting ...\n";
+          exit(EXIT_FAILURE);
+        }
+      } else {
+        if (! logger.is_open() ) {
+          logger.open( "Tracelog_" + timeStr + suffix );
+        }
+
+        if (! HBlogger.is_open()) {
+          HBlogger.open( "HBlog_" + timeStr + suffix );
+        }
+
+        if (! logger.is_open() || ! HBlogger.is_open() ) {
+          std::cerr << "Could not open log file \nExiting ...\n";
+          exit(EXIT_FAILURE);
+        }
       }
 
-      if (! logger.is_open() || ! HBlogger.is_open() ) {
-        std::cerr << "Could not open log file \nExiting ...\n";
-        exit(EXIT_FAILURE);
+      // the manifests are written by Finalize
+      if ( sharded ) return;
+
+      if ( ring.is_open() ) {
+        // no writer thread, the tasks write to the ring
+        if ( binaryTrace ) TraceFormat::writeHeader( ring );
+        return;
+      }
+
+      if ( binaryTrace ) {
+        TraceFormat::writeHeader( logger );
+        if ( !streaming ) TraceFormat::writeHeader( HBlogger );
       }
+
+      // from now on, the writer thread alone writes to the logger
+      loggerQueue.start( logger );
     }
 
     /** Generates a unique ID for each new task. */
@@ -122,7 +242,22 @@ class INS {
         funcID = funcIDSeed++;
         funcNames[funcName] = funcID;
         // print to the log file
-        logger << funcID << " F " << funcName << std::endl;
+        std::ostringstream line;
+        if ( binaryTrace ) {
+          TraceFormat::writeRecord(line, TraceFormat::FUNCTION,
+              0, 0, 0, 0, funcID, funcName, strlen(funcName));
+        } else {
+          line << funcID << " F " << funcName << std::endl;
+        }
+        std::string record = line.str();
+        if ( sharded ) {
+          // before the block of the task, in the shard of its thread
+          ThreadShard().trace << record;
+        } else if ( ring.is_open() ) {
+          ring.write( record.data(), record.size() );
+        } else {
+          loggerQueue.push( record );
+        }
       } else {
          funcID = fd->second;
       }
@@ -135,8 +270,30 @@ class INS {
     static inline VOID Finalize() {
       guardLock.lock();
 
+      // write the events still queued
+      loggerQueue.stop();
+
+      // the checker reads the ring up to its end
+      ring.finish();
+      ring.close();
+
+      // write the shards left and list them in the manifests
+      if ( sharded ) {
+        std::lock_guard<std::mutex> lock( shardsLock );
+        logger   << TRACE_MANIFEST_MAGIC "\n";
+        HBlogger << TRACE_MANIFEST_MAGIC "\n";
+        for (TraceShard *shard : shards) {
+          shard->trace.close();
+          shard->HB.close();
+          logger   << shard->trace.name + "\n";
+          HBlogger << shard->HB.name + "\n";
+          delete shard;
+        }
+        shards.clear();
+      }
+
       // Write HB relations to file
-      HBlogger << HBloggerBuffer.str();
+      if ( HBlogger.is_open() ) HBlogger << HBloggerBuffer.str();
 
       idMap.clear(); HB.clear();
       lastReader.clear(); lastWriter.clear();
@@ -147,17 +304,33 @@ class INS {
     }
 
     static inline VOID TransactionBegin( TaskInfo & task ) {
+      if ( binaryTrace ) {
+        TraceFormat::writeRecord(task.actionBuffer,
+            TraceFormat::TM_BEGIN, task.taskID);
+        return;
+      }
       task.actionBuffer << task.taskID << " BTM "
                         << task.taskName << std::endl;
     }
 
     static inline VOID TransactionEnd( TaskInfo & task ) {
+      if ( binaryTrace ) {
+        TraceFormat::writeRecord(task.actionBuffer,
+            TraceFormat::TM_END, task.taskID);
+        return;
+      }
       task.actionBuffer << task.taskID << " ETM "
                         << task.taskName << std::endl;
     }
 
     /** called when a task begins execution and retrieves parent task id */
     static inline VOID TaskBeginLog( TaskInfo& task) {
+      if ( binaryTrace ) {
+        TraceFormat::writeRecord(task.actionBuffer,
+            TraceFormat::TASK_BEGIN, task.taskID, 0, 0, 0, 0,
+            task.taskName, strlen(task.taskName));
+        return;
+      }
       task.actionBuffer << task.taskID << " B "
                         << task.taskName << std::endl;
     }
@@ -180,7 +353,23 @@ class INS {
 
         if (parentID != tid) {
           // there was a bug where a task could send token to itself
-          HBloggerBuffer << tid << " " << parentID << std::endl;
+          if ( streaming ) {
+            // the checker reads the edge from the receive event
+          } else if ( sharded ) {
+            TraceShard &shard = ThreadShard();
+            if ( binaryTrace ) {
+              TraceFormat::writeRecord(shard.HB,
+                  TraceFormat::HB_EDGE, tid, 0, parentID);
+            } else {
+              shard.HB << std::to_string(tid) + " " +
+                          std::to_string(parentID) + "\n";
+            }
+          } else if ( binaryTrace ) {
+            TraceFormat::writeRecord(HBloggerBuffer,
+                TraceFormat::HB_EDGE, tid, 0, parentID);
+          } else {
+            HBloggerBuffer << tid << " " << parentID << std::endl;
+          }
 
           // there is a happens before between taskID and parentID:
           //parentID ---happens-before---> taskID
@@ -193,8 +382,13 @@ class INS {
           if (HB.find( parentID ) != HB.end()) {
             HB[tid].insert(HB[parentID].begin(), HB[parentID].end());
           }
-          task.actionBuffer << tid << " C " << task.taskName << " "
-                            << parentID << std::endl;
+          if ( binaryTrace ) {
+            TraceFormat::writeRecord(task.actionBuffer,
+                TraceFormat::RECEIVE_TOKEN, tid, 0, parentID);
+          } else {
+            task.actionBuffer << tid << " C " << task.taskName << " "
+                              << parentID << std::endl;
+          }
         }
       }
       guardLock.unlock();
@@ -203,15 +397,45 @@ class INS {
     /** called before the task terminates. */
     static inline VOID TaskEndLog( TaskInfo& task ) {
 
-      task.printMemoryActions();
-      task.actionBuffer << task.taskID << " E "
-                        << task.taskName << std::endl;
+      if ( binaryTrace ) {
+        task.printMemoryActionsBinary();
+        TraceFormat::writeRecord(task.actionBuffer,
+            TraceFormat::TASK_END, task.taskID);
+      } else {
+        task.printMemoryActions();
+        task.actionBuffer << task.taskID << " E "
+                          << task.taskName << std::endl;
+      }
+      if ( ring.is_open() ) {
+        // copied from the buffer into the ring, no string is made
+        std::streambuf *events = task.actionBuffer.rdbuf();
+        size_t size = static_cast<size_t>( task.actionBuffer.tellp() );
+        ring.push(size, [events](char *destination, size_t count) {
+          events->sgetn(destination, count);
+        });
+        task.clearActionBuffer( size );
+        return;
+      }
 
-      guardLock.lock(); // protect file descriptor
-      logger << task.actionBuffer.str(); // print to file
-      guardLock.unlock();
+      std::string events = task.actionBuffer.str();
+      size_t size = events.size(); // the queue takes the events
+      if ( sharded ) {
+        // a block of the shard of this thread, numbered for the merge
+        TraceShard &shard = ThreadShard();
+        INTEGER sequence = blockSeed.fetch_add(1);
+        if ( binaryTrace ) {
+          TraceFormat::writeRecord(shard.trace, TraceFormat::SEQUENCE,
+              task.taskID, 0, sequence);
+        } else {
+          shard.trace << std::to_string(sequence) + " Q\n";
+        }
+        shard.trace << events;
+      } else {
+        // hand the events over to the writer thread, no lock
+        loggerQueue.push( events );
+      }
 
-      task.actionBuffer.str(""); // clear buffer
+      task.clearActionBuffer( size );
     }
 
     /**
@@ -224,8 +448,13 @@ class INS {
         INTEGER value ) {
 
       auto key = std::make_pair(bufLocAddr, value );
-      task.actionBuffer << task.taskID << " S "
-                        << task.taskName << std::endl;
+      if ( binaryTrace ) {
+        TraceFormat::writeRecord(task.actionBuffer,
+            TraceFormat::SEND_TOKEN, task.taskID);
+      } else {
+        task.actionBuffer << task.taskID << " S "
+                          << task.taskName << std::endl;
+      }
       guardLock.lock(); //  protect file descriptor & idMap
       idMap[key] = task.taskID;
       guardLock.unlock();
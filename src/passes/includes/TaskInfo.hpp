@@ -16,45 +16,72 @@
 #define _PASSES_INCLUDES_TASKINFO_HPP_
 
 #include "defs.hpp"
-#include "MemoryActions.hpp"
+#include "AccessTable.hpp"
+#include "traceFormat.hpp"
+
+// the bytes of the action buffer kept for the next task
+#define TASK_BUFFER_KEEP_BYTES (16 << 20)
 
 typedef struct TaskInfo {
   uint threadID    =  0;
   uint taskID      =  0;
   bool active      =  false;
-  char *taskName;
+  char *taskName   =  NULL;
 
   // stores pointers of signatures of functions executed by task
   // for faster acces
   std::unordered_map<STRING, INTEGER>         functions;
 
-  // stores memory actions performed by task.
-  std::unordered_map<address, MemoryActions>  memoryLocations;
+  // stores memory actions performed by task, emptied when the
+  // next task of the thread begins.
+  AccessTable                                 memoryLocations;
 
   // improve performance by buffering actions and write only once.
-  std::ostringstream                          actionBuffer;
+  // Readable too, so that a ring stream copies it out directly.
+  std::ostringstream actionBuffer{ std::ios_base::in };
+
+  /**
+   * Starts a task on this thread and forgets the accesses of the
+   * task it ran before. The action buffer was emptied when that
+   * task ended; the functions seen are kept.
+   */
+  inline void beginTask(uint thread, uint id, char *name) {
+    threadID = thread;
+    taskID   = id;
+    taskName = name;
+    active   = true;
+    memoryLocations.reset();
+  }
 
   /**
-   * Stores the action info as performed by task.
-   * The rules for storing this information are
-   * explained in MemoryActions.h
+   * Empties the action buffer once its "written" bytes are
+   * logged, keeping its memory unless it grew too large.
    */
-  inline void saveMemoryAction(Action &action) {
-    MemoryActions &loc = memoryLocations[action.addr];
-    loc.storeAction( action );
+  inline void clearActionBuffer(size_t written) {
+    if (written > TASK_BUFFER_KEEP_BYTES) {
+      std::ostringstream fresh{ std::ios_base::in };
+      actionBuffer.swap( fresh );
+    } else {
+      actionBuffer.str("");
+    }
   }
 
+  /**
+   * Stores the action info as performed by task: the
+   * first action on an address, or its last write.
+   */
   inline void saveReadAction(
       ADDRESS &addr,
       INTEGER &lineNo,
       const INTEGER funcID) {
-    MemoryActions & loc = memoryLocations[addr];
-
-    if ( loc.hasWrite() ) return;
-
-    Action action( taskID, addr, 0, lineNo, funcID );
-    action.isWrite = false;
-    loc.storeAction( action );
+    bool inserted;
+    TaskAccess &access = memoryLocations.insert(addr, inserted);
+    if ( !inserted ) return; // a read never replaces an action
+
+    access.value   = 0;
+    access.lineNo  = lineNo;
+    access.funcId  = funcID;
+    access.isWrite = false;
   }
 
   inline void saveWriteAction(
@@ -62,19 +89,37 @@ typedef struct TaskInfo {
       INTEGER value,
       INTEGER lineNo,
       INTEGER funcID) {
-     MemoryActions & loc = memoryLocations[addr];
+    bool inserted;
+    TaskAccess &access = memoryLocations.insert(addr, inserted);
 
-     bool isWrite = true;
-     loc.storeAction(taskID, addr, value, lineNo, funcID, isWrite);
+    access.value   = value;
+    access.lineNo  = lineNo;
+    access.funcId  = funcID;
+    access.isWrite = true;
   }
 
   /**
    * Prints to ostringstream all memory access actions
-   * recorded.
+   * recorded, as Action::printAction does.
    */
   void printMemoryActions() {
-    for (auto& memAction : memoryLocations) {
-      memAction.second.printActions( actionBuffer );
+    for (const TaskAccess &access : memoryLocations) {
+      actionBuffer << taskID << (access.isWrite ? " W " : " R ")
+                   << access.addr << " " << access.value << " "
+                   << access.lineNo << " " << access.funcId << std::endl;
+    }
+  }
+
+  /**
+   * Same as printMemoryActions, but appends the actions
+   * as binary records of traceFormat.hpp.
+   */
+  void printMemoryActionsBinary() {
+    for (const TaskAccess &access : memoryLocations) {
+      TraceFormat::writeRecord(actionBuffer,
+          access.isWrite ? TraceFormat::WRITE : TraceFormat::READ,
+          taskID, reinterpret_cast<uint64_t>(access.addr),
+          access.value, access.lineNo, access.funcId);
     }
   }
 
@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the destination of the logs written by the runtime:
+// a log file, or a stream to a running DFchecker. A stream is a
+// FIFO path, or "unix:path" for a local socket DFchecker listens on.
+
+#ifndef _PASSES_INCLUDES_TRACEOUTPUT_HPP_
+#define _PASSES_INCLUDES_TRACEOUTPUT_HPP_
+
+#include "defs.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// the prefix of local socket stream names
+#define TRACE_SOCKET_PREFIX "unix:"
+
+class TraceOutput {
+  public:
+    TraceOutput(): fd(-1) {}
+    ~TraceOutput() { close(); }
+
+    inline bool is_open() const { return fd >= 0; }
+
+    /** Creates or truncates the log file "name" */
+    bool open(const std::string &name) {
+      close();
+      fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      return is_open();
+    }
+
+    /**
+     * Connects to the stream "name" of a running checker.
+     * Opening a FIFO waits until the checker opens it.
+     */
+    bool openStream(const std::string &name) {
+      close();
+      signal(SIGPIPE, SIG_IGN); // a failed write closes the stream
+      size_t prefixLen = strlen(TRACE_SOCKET_PREFIX);
+      if (name.compare(0, prefixLen, TRACE_SOCKET_PREFIX) != 0) {
+        fd = ::open(name.c_str(), O_WRONLY);
+        return is_open();
+      }
+
+      std::string path = name.substr(prefixLen);
+      struct sockaddr_un address;
+      if (path.size() >= sizeof(address.sun_path)) return false;
+
+      memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      strcpy(address.sun_path, path.c_str());
+
+      fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd >= 0 && connect(fd,
+            reinterpret_cast<struct sockaddr *>(&address),
+            sizeof(address)) != 0) {
+        close();
+      }
+      return is_open();
+    }
+
+    /** Writes "size" bytes, retrying short writes */
+    VOID write(const char *data, size_t size) {
+      while (size > 0 && fd >= 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+          if (errno == EINTR) continue;
+          close(); // the checker went away
+          return;
+        }
+        data += written;
+        size -= written;
+      }
+    }
+
+    inline TraceOutput &operator<<(const std::string &text) {
+      write(text.data(), text.size());
+      return *this;
+    }
+
+    VOID close() {
+      if (fd >= 0) ::close(fd);
+      fd = -1;
+    }
+
+  private:
+    TraceOutput(const TraceOutput &);
+    TraceOutput &operator=(const TraceOutput &);
+
+    int fd;
+};
+
+#endif // end TraceOutput.hpp
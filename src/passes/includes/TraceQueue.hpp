@@ -0,0 +1,142 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the queue of trace chunks written by a background
+// thread. A task hands its events over as one chunk when it ends;
+// pushing is a compare-and-swap on the head of a lock-free stack,
+// so tasks never wait for a lock or for the log file. The writer
+// thread takes all the chunks at once, restores the order they
+// were pushed in and writes them in large batches.
+
+#ifndef _PASSES_INCLUDES_TRACEQUEUE_HPP_
+#define _PASSES_INCLUDES_TRACEQUEUE_HPP_
+
+#include "defs.hpp"
+#include "TraceOutput.hpp"
+#include <atomic>
+#include <thread>
+
+// bytes written to the log at once
+#define TRACE_BATCH_BYTES     (1 << 20)
+
+// tasks wait for the writer only if this many bytes are queued
+#define TRACE_QUEUE_MAX_BYTES (512UL << 20)
+
+// the pause of the writer thread when the queue is empty
+#define TRACE_WRITER_IDLE_US  200
+
+class TraceQueue {
+  public:
+    TraceQueue(): head(NULL), queuedBytes(0), stopping(false),
+                  running(false), output(NULL) {}
+
+    ~TraceQueue() { stop(); }
+
+    /** Starts the thread which writes the chunks to "out" */
+    VOID start(TraceOutput &out) {
+      if ( running.load(std::memory_order_acquire) ) return;
+      output   = &out;
+      stopping = false;
+      writer   = std::thread(&TraceQueue::writeChunks, this);
+      running.store(true, std::memory_order_release);
+    }
+
+    /** Writes the chunks left and stops the writer thread */
+    VOID stop() {
+      if ( !running.exchange(false, std::memory_order_acq_rel) ) return;
+      stopping.store(true, std::memory_order_release);
+      writer.join();
+    }
+
+    /** Hands "data" over to the writer, leaving it empty */
+    VOID push(std::string &data) {
+      if ( data.empty() ) return;
+
+      // bounds the memory if the log can not keep up
+      while (queuedBytes.load(std::memory_order_relaxed) >
+                 TRACE_QUEUE_MAX_BYTES &&
+             running.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+
+      Chunk *chunk = new Chunk();
+      chunk->data.swap(data);
+      queuedBytes.fetch_add(chunk->data.size(), std::memory_order_relaxed);
+
+      chunk->next = head.load(std::memory_order_relaxed);
+      while ( !head.compare_exchange_weak(chunk->next, chunk,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed) ) {}
+    }
+
+  private:
+    struct Chunk {
+      std::string  data;
+      Chunk       *next;
+    };
+
+    VOID writeChunks() {
+      std::string batch;
+      batch.reserve(TRACE_BATCH_BYTES);
+
+      while (true) {
+        BOOL last = stopping.load(std::memory_order_acquire);
+        Chunk *chunks = head.exchange(NULL, std::memory_order_acquire);
+        if ( !chunks ) {
+          if ( last ) break; // nothing pushed before the stop
+          std::this_thread::sleep_for(
+              std::chrono::microseconds(TRACE_WRITER_IDLE_US));
+          continue;
+        }
+
+        // the stack holds the newest chunk first
+        Chunk *ordered = NULL;
+        while ( chunks ) {
+          Chunk *next  = chunks->next;
+          chunks->next = ordered;
+          ordered      = chunks;
+          chunks       = next;
+        }
+
+        while ( ordered ) {
+          Chunk *chunk = ordered;
+          ordered = chunk->next;
+
+          if (batch.size() + chunk->data.size() > TRACE_BATCH_BYTES) {
+            output->write(batch.data(), batch.size());
+            batch.clear();
+          }
+          if (chunk->data.size() >= TRACE_BATCH_BYTES) {
+            output->write(chunk->data.data(), chunk->data.size());
+          } else {
+            batch.append(chunk->data);
+          }
+          queuedBytes.fetch_sub(chunk->data.size(),
+                                std::memory_order_relaxed);
+          delete chunk;
+        }
+
+        // a running checker reads the events as they come
+        output->write(batch.data(), batch.size());
+        batch.clear();
+      }
+    }
+
+    std::atomic<Chunk *>  head; // the newest chunk
+    std::atomic<size_t>   queuedBytes;
+    std::atomic<bool>     stopping;
+    std::atomic<bool>     running; // read by the tasks, unlike "writer"
+    TraceOutput          *output;
+    std::thread           writer;
+};
+
+#endif // end TraceQueue.hpp
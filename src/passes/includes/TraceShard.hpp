@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////////
+//  DFinspec: a lightweight non-determinism checking
+//          tool for ADF applications
+//
+//    Copyright (c) 2015 - 2018 Hassan Salehe Matar
+//      Copying or using this code by any means whatsoever
+//      without consent of the owner is strictly prohibited.
+//
+//   Contact: hmatar-at-ku-dot-edu-dot-tr
+//
+/////////////////////////////////////////////////////////////////
+
+// Defines the logs written by a single thread when the logs are
+// sharded (DFINSPEC_TRACE_SHARDS=1). Only the owning thread writes
+// to its shard, so the events are buffered without any lock and
+// the log file is written in large batches.
+
+#ifndef _PASSES_INCLUDES_TRACESHARD_HPP_
+#define _PASSES_INCLUDES_TRACESHARD_HPP_
+
+#include "defs.hpp"
+#include "TraceOutput.hpp"
+
+// bytes buffered by a thread before they are written
+#define TRACE_SHARD_BYTES (1 << 20)
+
+class ShardLog {
+  public:
+    /** Creates or truncates the shard file "name_" */
+    bool open(const std::string &name_) {
+      name = name_;
+      buffer.reserve(TRACE_SHARD_BYTES);
+      return output.open(name);
+    }
+
+    /** Appends "size" bytes, writing the buffer once it is full */
+    VOID write(const char *data, size_t size) {
+      buffer.append(data, size);
+      if (buffer.size() >= TRACE_SHARD_BYTES) flush();
+    }
+
+    inline ShardLog &operator<<(const std::string &text) {
+      write(text.data(), text.size());
+      return *this;
+    }
+
+    VOID flush() {
+      output.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+
+    VOID close() {
+      flush();
+      output.close();
+    }
+
+    std::string  name;
+
+  private:
+    TraceOutput  output;
+    std::string  buffer;
+};
+
+// the Tracelog and HBlog shards of a thread
+typedef struct TraceShard {
+  ShardLog  trace;
+  ShardLog  HB;
+} TraceShard;
+
+#endif // end TraceShard.hpp